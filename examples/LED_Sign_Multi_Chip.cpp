@@ -21,6 +21,7 @@
  */
 
 #include "IS31FL373x.h"
+#include "IS31FL373x_Scheduler.h"
 
 // Three IS31FL3737 hardware chips with proper driver classes
 IS31FL3737 board1(ADDR::GND);  // Address: 0x50
@@ -30,6 +31,7 @@ IS31FL3737 board3(ADDR::SDA);  // Address: 0x52
 // Create device array and canvas
 IS31FL373x_Device* devices[] = {&board1, &board2, &board3};
 IS31FL373x_Canvas sign(36, 12, devices, 3, LAYOUT_HORIZONTAL);
+IS31FL373x_FrameScheduler pacer(&sign, 20);  // Scroll at a steady 20 frames per second
 
 // Configuration
 const int LIGHT_SENSOR_PIN = A0;
@@ -67,12 +69,20 @@ void setup() {
     Serial.println("Configuration complete!");
     Serial.println("Starting scrolling text demonstration...");
     Serial.println();
+    pacer.start();
 }
 
 void loop() {
     // Automatic brightness adaptation based on light sensor
     adaptBrightness();
     
+    // Draw only when the next frame is due; the rest of loop() stays responsive
+    if (!pacer.frameDue()) return;
+    
+    // Dropped frames still advance the scroll, so speed does not depend on bus time
+    int messageWidth = strlen(MESSAGE) * 6;  // Approximate character width
+    scrollPosition = 36 - static_cast<int>(pacer.getFrameNumber() % (36 + messageWidth));
+    
     // Clear the display
     sign.clear();
     
@@ -81,29 +91,23 @@ void loop() {
     sign.print(MESSAGE);
     
     // Update the display
-    sign.show();
-    
-    // Move text position for scrolling effect
-    scrollPosition--;
-    
-    // Reset position when message scrolls completely off screen
-    int messageWidth = strlen(MESSAGE) * 6;  // Approximate character width
-    if (scrollPosition < -messageWidth) {
-        scrollPosition = 36;  // Reset to right edge
-    }
+    pacer.show();
     
     // Performance monitoring
     static unsigned long lastReport = 0;
     if (millis() - lastReport > 5000) {  // Report every 5 seconds
         Serial.print("Sign FPS: ");
-        Serial.print(sign.getFPS());
+        Serial.print(pacer.getAchievedFps());
+        Serial.print(" | Jitter: ");
+        Serial.print(pacer.getJitterMicros());
+        Serial.print(" us | Dropped: ");
+        Serial.print(pacer.getFramesDropped());
         Serial.print(" | Global Dimming: ");
         Serial.print(getCurrentDimming());
         Serial.println("%");
         lastReport = millis();
+        pacer.resetStats();
     }
-    
-    delay(50);  // Control scroll speed
 }
 
 /**
@@ -157,7 +161,7 @@ int getCurrentDimming() {
  * 3. PERFORMANCE:
  *    - Monitor FPS to optimize refresh rate
  *    - Typical performance: 30-60 FPS for 3-chip setup
- *    - Reduce delay() in loop() for faster scrolling
+ *    - Raise the scheduler's frame rate for faster scrolling
  * 
  * 4. CUSTOMIZATION:
  *    - Change MESSAGE for different text
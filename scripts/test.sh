@@ -29,6 +29,26 @@ if [ -f "$TEST_LOG" ]; then
     grep -E '^\[doctest\] (test cases|assertions|Status:)' "$TEST_LOG" | sed 's/^/    /'
 fi
 
+echo "📋 Running Unit Tests (static allocation build)..."
+if pio test -e native_test_static > /tmp/native_test_static_output.log 2>&1; then
+    echo "    ✅ Static allocation unit tests passed"
+else
+    echo "    ❌ Static allocation unit tests failed"
+    tail -5 /tmp/native_test_static_output.log | sed 's/^/       /'
+    OVERALL_SUCCESS=false
+    FAILED_TESTS+=("unit_tests_static")
+fi
+
+echo "📋 Running Unit Tests (instrumented build)..."
+if pio test -e native_test_instrumented > /tmp/native_test_instrumented_output.log 2>&1; then
+    echo "    ✅ Instrumented unit tests passed"
+else
+    echo "    ❌ Instrumented unit tests failed"
+    tail -5 /tmp/native_test_instrumented_output.log | sed 's/^/       /'
+    OVERALL_SUCCESS=false
+    FAILED_TESTS+=("unit_tests_instrumented")
+fi
+
 echo ""
 echo "🔨 Testing Hardware Compilation..."
 
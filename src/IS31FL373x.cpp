@@ -10,6 +10,13 @@ void delay(unsigned long ms) {
     // No-op in unit tests
 }
 
+// Mock microsecond clock, advanced by the mock I2C layer to model bus time
+unsigned long mockMicros = 0;
+uint32_t mockBusClock = 0;
+unsigned long micros() {
+    return mockMicros;
+}
+
 // Mock I2C tracking implementation
 std::vector<MockI2COperation> mockI2COperations;
 
@@ -45,29 +52,35 @@ bool mockI2CContainsWrite(uint8_t reg, uint8_t value) {
     return false;
 }
 
-bool Adafruit_I2CDevice::write(uint8_t* buffer, size_t len) {
-    if (buffer == nullptr || len == 0) return true;
+bool Adafruit_I2CDevice::write(const uint8_t* buffer, size_t len, bool stop,
+                               const uint8_t* prefix_buffer, size_t prefix_len) {
+    (void)stop;
+    if (prefix_buffer == nullptr) prefix_len = 0;
+    if ((buffer == nullptr || len == 0) && prefix_len == 0) return true;
+    
+    // BusIO sends the prefix and payload as one transaction; record them joined
+    std::vector<uint8_t> bytes(prefix_buffer, prefix_buffer + prefix_len);
+    if (buffer != nullptr) bytes.insert(bytes.end(), buffer, buffer + len);
+    len = bytes.size();
     
     // Track I2C writes in tests: both 1-byte (address latch) and 2+ byte (reg/value)
     MockI2COperation op;
     op.addr = _addr;
-    op.reg = buffer[0];
-    op.value = (len >= 2) ? buffer[1] : 0;
+    op.reg = bytes[0];
+    op.value = (len >= 2) ? bytes[1] : 0;
     op.isWrite = true;
     
     // For bulk writes (>2 bytes), store all data
     if (len > 2) {
-        op.bulkData.reserve(len - 1);
-        for (size_t i = 1; i < len; i++) {
-            op.bulkData.push_back(buffer[i]);
-        }
+        op.bulkData.assign(bytes.begin() + 1, bytes.end());
     }
     
     mockI2COperations.push_back(op);
+    mockMicros += 25 * len;  // ~400 kHz: 9 bit times per byte
     
     // Remember last addressed register for subsequent read tracing
     if (len == 1) {
-        _lastReg = buffer[0];
+        _lastReg = bytes[0];
     }
     
     return true;
@@ -76,80 +89,139 @@ bool Adafruit_I2CDevice::write(uint8_t* buffer, size_t len) {
 #include <Arduino.h>  // for delay() function
 #endif
 
+// Counter updates vanish unless IS31FL373X_ENABLE_STATS is defined
+#ifdef IS31FL373X_ENABLE_STATS
+#define IS31FL373X_STAT(statement) do { statement; } while (0)
+#else
+#define IS31FL373X_STAT(statement) do { } while (0)
+#endif
+
+// Trace hook calls vanish unless IS31FL373X_ENABLE_TRACE is defined
+#ifdef IS31FL373X_ENABLE_TRACE
+static IS31FL373x_TraceHook traceHook = nullptr;
+static void* traceContext = nullptr;
+
+void IS31FL373x_setTraceHook(IS31FL373x_TraceHook hook, void* context) {
+    traceHook = hook;
+    traceContext = context;
+}
+
+static void emitTrace(IS31FL373x_TraceEvent event, bool begin, uint8_t addr, uint8_t reg, uint16_t length) {
+    if (traceHook == nullptr) return;
+    IS31FL373x_TraceRecord record = {event, begin, addr, reg, length, static_cast<uint32_t>(micros())};
+    traceHook(record, traceContext);
+}
+#define IS31FL373X_TRACE(event, begin, addr, reg, length) emitTrace(event, begin, addr, reg, length)
+#else
+#define IS31FL373X_TRACE(event, begin, addr, reg, length) do { } while (0)
+#endif
+
 // Stub implementations for basic compilation testing
 // Full implementation will be added incrementally
 
 IS31FL373x_Device::IS31FL373x_Device(uint8_t addr, TwoWire *wire) 
-    : Adafruit_GFX(12, 12), _i2c_dev(nullptr), _pwmBuffer(nullptr),
-      _globalCurrent(128), _masterBrightness(255), _addr(addr), _wire(wire),
+    : Adafruit_GFX(12, 12), _i2c_dev(nullptr), _pwmBuffer(nullptr), _bufferStride(0),
+      _ownsBuffer(false), _pixelFormat(PIXEL_FORMAT_8BIT), _globalCurrent(128), _masterBrightness(255), _addr(addr), _wire(wire),
       _customLayout(nullptr), _layoutSize(0), _useCustomLayout(false), 
       _csOffset(0), _swOffset(0) {
     // Store parameters for delayed initialization in begin()
     // DON'T create Adafruit_I2CDevice here to avoid static initialization issues
+    setDefaultPalette();
 }
 
 IS31FL373x_Device::~IS31FL373x_Device() {
-    if (_i2c_dev) {
-        delete _i2c_dev;
-        _i2c_dev = nullptr;
-    }
-    if (_pwmBuffer) {
-#ifdef UNIT_TEST
-        std::free(_pwmBuffer);
+    if (_i2c_dev && _ownsI2CDevice) {
+#ifdef IS31FL373X_STATIC_ALLOCATION
+        _i2c_dev->~Adafruit_I2CDevice();  // Constructed in place; storage is a member
 #else
-        delete[] _pwmBuffer;
+        delete _i2c_dev;
 #endif
-        _pwmBuffer = nullptr;
     }
+    _i2c_dev = nullptr;
+    if (isBatching()) {
+        // Queued writes cannot be sent without the device; drop them
+        _batchOwner = nullptr;
+        _batchDepth = 0;
+        _queueLength = 0;
+    }
+    releaseBuffer();
 }
 
 bool IS31FL373x_Device::begin() {
-    // Create I2C device here when Wire is properly initialized
-    if (_i2c_dev == nullptr) {
-        _i2c_dev = new Adafruit_I2CDevice(_addr, _wire);
+    // A transport owns the bus itself; otherwise create the I2C device here
+    // when Wire is properly initialized
+    if (_transport == nullptr) {
         if (_i2c_dev == nullptr) {
+#ifdef IS31FL373X_STATIC_ALLOCATION
+            _i2c_dev = new (_i2cStorage) Adafruit_I2CDevice(_addr, _wire);
+#else
+            _i2c_dev = new Adafruit_I2CDevice(_addr, _wire);
+#endif
+            if (_i2c_dev == nullptr) {
+                return false;
+            }
+            _ownsI2CDevice = true;
+        }
+        
+        // Initialize I2C device
+        if (!_i2c_dev->begin()) {
             return false;
         }
     }
+    // A range set before begin() had no bus to apply to yet
+    if (_clockPolicy.enabled()) applyBusClock(_clockPolicy.clockHz);
     
-    // Initialize I2C device
-    if (!_i2c_dev->begin()) {
+    // Allocate PWM buffer unless the caller attached one
+    if (_pwmBuffer == nullptr && !allocateBuffer()) {
         return false;
     }
     
-    // Allocate PWM buffer
-    if (_pwmBuffer == nullptr) {
-#ifdef UNIT_TEST
-        _pwmBuffer = static_cast<uint8_t*>(std::malloc(getPWMBufferSize()));
-#else
-        _pwmBuffer = new uint8_t[getPWMBufferSize()];
-#endif
-        if (_pwmBuffer == nullptr) {
-            return false;
-        }
-        memset(_pwmBuffer, 0, getPWMBufferSize());
+    // Page register state is unknown until the first select
+    _currentPage = IS31FL373X_PAGE_UNKNOWN;
+    _asleep = false;
+    _waking = false;
+    _darkFrames = 0;
+    _framesSinceProbe = 0;
+    updateCurrentSplit();
+    _warmStarted = _warmStart && verifyConfiguration();
+    if (_warmStarted) {
+        // Configuration survived: keep the chip lit and resend the frame on the next show()
+        markDirty();
+        selectPage(IS31FL373X_PAGE_PWM);
+        return true;
     }
     
     // Software reset
     reset();
+    restoreConfiguration();
+    
+    // Switch to PWM page for normal operation
+    selectPage(IS31FL373X_PAGE_PWM);
+    
+    return true;
+}
+
+bool IS31FL373x_Device::restoreConfiguration() {
+    // Queued, so the LED enables go out as one burst and each page is selected once
+    beginRegisterBatch();
     
     // Enable all LEDs (LED Control Page)
-    selectPage(IS31FL373X_PAGE_LED_CTRL);
+    bool ok = selectPage(IS31FL373X_PAGE_LED_CTRL);
     // LED Control registers are 0x00-0x17 (24 registers total)
     // Each register controls 8 LEDs with bitwise mapping
     for (uint8_t i = 0x00; i <= 0x17; i++) {
-        writeRegister(i, 0xFF); // Enable all LEDs in this register
+        ok &= writeRegister(i, 0xFF); // Enable all LEDs in this register
     }
     
     // Configure Function Page
-    selectPage(IS31FL373X_PAGE_FUNCTION);
-    writeRegister(0x00, 0x01); // Configuration Register: SSD=1 (Normal Operation)
-    writeRegister(0x01, _globalCurrent); // Global Current Control
-    
-    // Switch to PWM page for normal operation
-    selectPage(IS31FL373X_PAGE_PWM);
-    
-    return true;
+    ok &= selectPage(IS31FL373X_PAGE_FUNCTION);
+    ok &= writeRegister(0x00, 0x01); // Configuration Register: SSD=1 (Normal Operation)
+    ok &= writeRegister(0x01, _appliedCurrent); // Global Current Control
+    ok &= commitRegisterBatch();
+    _asleep = false;
+    _waking = false;
+    _darkFrames = 0;
+    return ok;
 }
 
 void IS31FL373x_Device::reset() {
@@ -157,21 +229,340 @@ void IS31FL373x_Device::reset() {
     selectPage(IS31FL373X_PAGE_FUNCTION);
     uint8_t dummy;
     readRegister(0x11, &dummy); // Software reset by reading register 0x11
+    _currentPage = IS31FL373X_PAGE_UNKNOWN;  // Registers return to power-on defaults
+    markDirty();                             // PWM registers no longer match the buffer
     delay(10); // Wait for reset to complete
 }
 
 void IS31FL373x_Device::show() {
     if (_pwmBuffer == nullptr) return;
+    pollHealth();
+    trackDarkFrames();
+    flushIfDirty();
+    updateSleep();
+}
+
+void IS31FL373x_Device::flushIfDirty() {
+    // Unchanged frame (or a dark one while asleep): no bus traffic at all
+    if (!isDirty()) {
+        IS31FL373X_STAT(_stats.framesSkipped++);
+        return;
+    }
+    // While dithering, only rows with fractional levels stay dirty between frames
+    bool partial = (_pixelFormat == PIXEL_FORMAT_16BIT) && !isBufferAttached();
+    flushFrame(partial ? _dirtyRows : IS31FL373X_ALL_ROWS);
+}
+
+bool IS31FL373x_Device::showIncremental(uint16_t maxBytes) {
+    if (_pwmBuffer == nullptr) return true;
+    // Health probes and sleep/wake writes are left to show() so maxBytes is a hard
+    // bound; counting dark frames costs no bus traffic
+    trackDarkFrames();
+    if (!isDirty()) {
+        IS31FL373X_STAT(_stats.framesSkipped++);
+        return true;
+    }
+    beginIncremental();
+    IS31FL373x_Device* self = this;
+    while (pickStaleRow(&self, 1, maxBytes)) {
+    }
+    if (_pendingRows == 0) return false;  // Budget too small for a single row
+    flushPending();
+    return _dirtyRows == 0;
+}
+
+void IS31FL373x_Device::setAutoSleep(uint8_t frames) {
+    _autoSleepFrames = frames;
+    _darkFrames = 0;
+    if (frames == 0 && _asleep) {
+        _asleep = false;
+        _waking = true;
+        markDirty();  // Rows drawn dark while asleep may not have been sent
+        updateSleep();
+    }
+}
+
+void IS31FL373x_Device::trackDarkFrames() {
+    if (_autoSleepFrames == 0) return;
+    // O(1): the non-zero count is maintained by the write paths
+    if (getNonZeroPixelCount() != 0) {
+        _darkFrames = 0;
+        if (_asleep) {
+            _asleep = false;
+            _waking = true;  // Send the frame first so the chip wakes up showing it
+        }
+    } else if (_darkFrames < _autoSleepFrames) {
+        _darkFrames++;
+    }
+}
+
+void IS31FL373x_Device::updateSleep() {
+    if (_waking) {
+        if (writeConfiguration(true)) _waking = false;
+        return;
+    }
+    // Sleep only once the dark frame has reached the registers, so waking never
+    // briefly shows stale content
+    if (_autoSleepFrames == 0 || _asleep || _darkFrames < _autoSleepFrames || isDirty()) return;
+    if (writeConfiguration(false)) _asleep = true;
+}
+
+bool IS31FL373x_Device::readConfiguration(uint8_t* config, uint8_t* current) {
+    // Never touch 0x11 here: reading it is the soft reset
+    if (!selectPage(IS31FL373X_PAGE_FUNCTION)) return false;
+    return readRegister(0x00, config) && readRegister(0x01, current);
+}
+
+bool IS31FL373x_Device::matchesConfiguration(uint8_t config, uint8_t current) const {
+    // SSD stays cleared while asleep, and until the wake frame has been sent
+    uint8_t expected = (_asleep || _waking) ? 0x00 : 0x01;
+    return config == expected && current == _appliedCurrent;
+}
+
+bool IS31FL373x_Device::verifyConfiguration() {
+    uint8_t config = 0, current = 0;
+    return readConfiguration(&config, &current) && matchesConfiguration(config, current);
+}
+
+bool IS31FL373x_Device::checkHealth() {
+    uint8_t config = 0, current = 0;
+    if (!readConfiguration(&config, &current)) return false;  // Not answering; retried at the next probe
+    if (matchesConfiguration(config, current)) return true;
+    
+    // The chip reset itself (e.g. supply brownout): every register is back at its
+    // power-on default. Restore this chip only and resend its whole frame.
+    _currentPage = IS31FL373X_PAGE_UNKNOWN;
+    restoreConfiguration();
+    markDirty();
+    _resyncs++;
+    return false;
+}
+
+void IS31FL373x_Device::pollHealth() {
+    if (_healthInterval == 0 || ++_framesSinceProbe < _healthInterval) return;
+    _framesSinceProbe = 0;
+    checkHealth();
+}
+
+bool IS31FL373x_Device::writeConfiguration(bool normalOperation) {
+    // Configuration Register: SSD=1 for normal operation, 0 for software shutdown
+    if (!selectPage(IS31FL373X_PAGE_FUNCTION)) return false;
+    return writeRegister(0x00, normalOperation ? 0x01 : 0x00);
+}
+
+void IS31FL373x_Device::flushFrame(uint16_t rows) {
+    IS31FL373X_TRACE(TRACE_SHOW, true, _addr, IS31FL373X_PAGE_PWM, 0);
+    // A frame is one transport batch (nested inside the canvas batch, if any)
+    if (_transport != nullptr) _transport->beginBatch();
+#ifdef IS31FL373X_ENABLE_STATS
+    unsigned long start = micros();
+#endif
+    _ditherRows = 0;
+    bool success = (rows == IS31FL373X_ALL_ROWS) ? flushBuffer() : flushRows(rows);
+    if (_transport != nullptr && !_transport->endBatch()) {
+        recordBatchError();
+        success = false;
+    }
+    if (success) {
+        _dirtyRows &= static_cast<uint16_t>(~rows);
+        if (_pixelFormat == PIXEL_FORMAT_16BIT) {
+            // Dithered rows change every frame; re-arm just those (with a fresh age)
+            _ditherPhase++;
+            for (uint8_t row = 0; row < IS31FL373X_MAX_ROWS; row++) {
+                if (_ditherRows & rows & (1u << row)) markRows(row, static_cast<uint8_t>(row + 1));
+            }
+        }
+    }
+#ifdef IS31FL373X_ENABLE_STATS
+    _stats.recordFlush(static_cast<uint32_t>(micros() - start));
+#endif
+    if (_clockPolicy.enabled() && _clockPolicy.update(_errorCount)) applyBusClock(_clockPolicy.clockHz);
+    IS31FL373X_TRACE(TRACE_SHOW, false, _addr, IS31FL373X_PAGE_PWM, 0);
+}
+
+void IS31FL373x_Device::setBusClockRange(uint32_t minHz, uint32_t maxHz) {
+    _clockPolicy.configure(minHz, maxHz, _errorCount);
+    if (_clockPolicy.enabled()) applyBusClock(_clockPolicy.clockHz);
+}
+
+void IS31FL373x_Device::recordBatchError() {
+    // Counts like a failed write so the clock policy backs off on batching transports too
+    _errorCount++;
+    IS31FL373X_STAT(_stats.errors++);
+    forgetBusState();
+}
+
+void IS31FL373x_Device::forgetBusState() {
+    _currentPage = IS31FL373X_PAGE_UNKNOWN;
+    if (_transport != nullptr) IS31FL373x_Mux::invalidateAll(_transport);
+}
+
+void IS31FL373x_Device::applyBusClock(uint32_t hz) {
+    if (_transport != nullptr) {
+        _transport->setClock(hz);
+    } else if (_i2c_dev != nullptr) {
+        _i2c_dev->setSpeed(hz);
+    }
+}
+
+void IS31FL373x_ClockPolicy::configure(uint32_t minClock, uint32_t maxClock, uint32_t errors) {
+    minHz = (minClock < maxClock) ? minClock : maxClock;
+    maxHz = maxClock;
+    clockHz = maxClock;  // Start fast; errors bring it down
+    windowFrames = 0;
+    windowStartErrors = errors;
+}
+
+bool IS31FL373x_ClockPolicy::update(uint32_t errors) {
+    windowFrames++;
+    uint32_t windowErrors = errors - windowStartErrors;
+    uint32_t next = clockHz;
+    if (windowErrors >= IS31FL373X_CLOCK_ERROR_THRESHOLD) {
+        next = (clockHz / 2 > minHz) ? clockHz / 2 : minHz;
+    } else if (windowFrames < IS31FL373X_CLOCK_WINDOW) {
+        return false;
+    } else if (windowErrors == 0) {
+        next = (clockHz < maxHz / 2) ? clockHz * 2 : maxHz;
+    }
+    // Either way a new window starts, so one burst of errors steps down only once
+    windowFrames = 0;
+    windowStartErrors = errors;
+    if (next == clockHz) return false;
+    clockHz = next;
+    return true;
+}
+
+void IS31FL373x_Device::beginIncremental() {
+    // Attached buffers are refreshed round-robin: start a new pass once one completes
+    if (_dirtyRows == 0 && isBufferAttached()) markDirty();
+    _pendingRows = 0;
+}
+
+uint16_t IS31FL373x_Device::getRowFlushCost() const {
+    // Custom layouts write pixel by pixel (address, register, value)
+    if (_useCustomLayout && _customLayout != nullptr && _layoutSize > 0) {
+        return static_cast<uint16_t>(getWidth()) * 3;
+    }
+    return static_cast<uint16_t>(getRegisterStride()) + 2;  // Address + start register + row
+}
+
+uint8_t IS31FL373x_Device::getFlushOverhead() const {
+    uint8_t cost = 0;
+    if (!_pageCaching || _currentPage != IS31FL373X_PAGE_PWM) cost += 6;  // Unlock + page select
+    if (_mux != nullptr) cost += _mux->getMaxSelectBytes();                // Possible channel switch
+    return cost;
+}
+
+void IS31FL373x_Device::flushPending() {
+    // Retries and writes after a failure would go past the planned bytes; the rows
+    // stay dirty instead and a later call resends them
+    _budgeted = true;
+    _budgetFailed = false;
+    flushFrame(_pendingRows);
+    _pendingRows = 0;
+    _budgeted = false;
+    _budgetFailed = false;
+}
+
+bool IS31FL373x_Device::pickStaleRow(IS31FL373x_Device* const* devices, uint8_t count, uint16_t& budget) {
+    // Age is measured against the shared clock, so it wraps safely and compares across devices
+    IS31FL373x_Device* best = nullptr;
+    uint8_t bestRow = 0;
+    uint16_t bestAge = 0;
+    uint16_t bestCost = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        IS31FL373x_Device* device = devices[i];
+        if (device == nullptr || device->_pwmBuffer == nullptr) continue;
+        uint16_t candidates = device->_dirtyRows & static_cast<uint16_t>(~device->_pendingRows);
+        if (candidates == 0) continue;
+        uint16_t cost = device->getRowFlushCost();
+        if (device->_pendingRows == 0) cost += device->getFlushOverhead();
+        if (cost > budget) continue;
+        for (uint8_t row = 0; row < IS31FL373X_MAX_ROWS; row++) {
+            if (!(candidates & (1u << row))) continue;
+            uint16_t age = static_cast<uint16_t>(_dirtyClock - device->_dirtySince[row]);
+            if (best == nullptr || age > bestAge) {
+                best = device;
+                bestRow = row;
+                bestAge = age;
+                bestCost = cost;
+            }
+        }
+    }
+    if (best == nullptr) return false;
+    best->_pendingRows |= static_cast<uint16_t>(1u << bestRow);
+    budget = static_cast<uint16_t>(budget - bestCost);
+    return true;
+}
+
+bool IS31FL373x_Device::flushRows(uint16_t rows) {
+    if (!selectPage(IS31FL373X_PAGE_PWM)) {
+        return false;
+    }
     
+    uint8_t width = getWidth();
+    bool success = true;
+    if (_useCustomLayout && _customLayout != nullptr && _layoutSize > 0) {
+        uint16_t maxIndex = (_layoutSize < getPWMBufferSize()) ? _layoutSize : getPWMBufferSize();
+        for (uint16_t i = 0; i < maxIndex; i++) {
+            uint8_t y = static_cast<uint8_t>(i / width);
+            if (!(rows & (1u << y))) continue;
+            const PixelMapEntry& entry = _customLayout[i];
+            uint16_t csAdjusted = static_cast<uint16_t>(entry.cs) + _csOffset;
+            uint16_t swAdjusted = static_cast<uint16_t>(entry.sw) + _swOffset;
+            if (csAdjusted == 0 || csAdjusted > 255 || swAdjusted == 0 || swAdjusted > 255) continue;
+            if (!isValidCsSw(static_cast<uint8_t>(csAdjusted), static_cast<uint8_t>(swAdjusted))) continue;
+            uint16_t regAddress = csSwToIndex(static_cast<uint8_t>(csAdjusted), static_cast<uint8_t>(swAdjusted));
+            if (regAddress != 0xFFFF) {
+                success &= writeRegister(static_cast<uint8_t>(regAddress), flushValue(i % width, y));
+            }
+        }
+        return success;
+    }
+    
+    // Logical row y lives in register row y + swOffset; rows pushed past the
+    // chip are dropped, as in a full flush. Adjacent rows go out as one burst.
+    uint8_t height = getHeight();
+    uint8_t stride = getRegisterStride();
+    uint8_t rowsPerChunk = static_cast<uint8_t>(IS31FL373X_BULK_CHUNK_SIZE / stride);
+    if (rowsPerChunk == 0) return false;
+    
+    uint8_t chunk[IS31FL373X_BULK_CHUNK_SIZE];
+    uint8_t y = 0;
+    while (y < height && success) {
+        if (!(rows & (1u << y))) {
+            y++;
+            continue;
+        }
+        uint8_t run = 1;
+        while (y + run < height && run < rowsPerChunk && (rows & (1u << (y + run)))) run++;
+        uint16_t regRow = static_cast<uint16_t>(y) + _swOffset;
+        if (regRow < height) {
+            uint8_t sendRows = (regRow + run > height) ? static_cast<uint8_t>(height - regRow) : run;
+            size_t length = static_cast<size_t>(sendRows) * stride;
+            if (_pixelFormat == PIXEL_FORMAT_NATIVE && !hasOutputTransform()) {
+                success = writeBulk(static_cast<uint8_t>(regRow * stride), &_pwmBuffer[regRow * stride], length);
+            } else {
+                packRegisterRows(static_cast<uint8_t>(regRow), sendRows, chunk);
+                success = writeBulk(static_cast<uint8_t>(regRow * stride), chunk, length);
+            }
+        }
+        y = static_cast<uint8_t>(y + run);
+    }
+    return success;
+}
+
+bool IS31FL373x_Device::flushBuffer() {
     // Switch to PWM page
     if (!selectPage(IS31FL373X_PAGE_PWM)) {
-        return;
+        return false;
     }
     
     // When a custom layout is active, iterate layout entries instead of matrix scan
     // Custom layouts still use individual writes since they may be sparse/non-contiguous
     if (_useCustomLayout && _customLayout != nullptr && _layoutSize > 0) {
         uint16_t maxIndex = (_layoutSize < getPWMBufferSize()) ? _layoutSize : getPWMBufferSize();
+        bool success = true;
         for (uint16_t i = 0; i < maxIndex; i++) {
             const PixelMapEntry& entry = _customLayout[i];
             // entry.cs and entry.sw are 1-based; apply offsets here
@@ -191,67 +582,234 @@ void IS31FL373x_Device::show() {
 
             uint16_t regAddress = csSwToIndex(cs, sw);
             if (regAddress != 0xFFFF) {
-                writeRegister(static_cast<uint8_t>(regAddress), _pwmBuffer[i]);
+                success &= writeRegister(static_cast<uint8_t>(regAddress), flushValue(i % getWidth(), i / getWidth()));
             }
         }
-        return;
+        return success;
     }
     
-    // Use bulk writes for default matrix layout
-    // Build hardware register buffer respecting the chip's register stride
-    uint8_t width = getWidth();
+    // Native storage already is the register image: burst it out untouched
+    // (output transforms fall through to the packing path)
+    if (_pixelFormat == PIXEL_FORMAT_NATIVE && !hasOutputTransform()) {
+        return writeBulk(0x00, _pwmBuffer, getBufferBytes());
+    }
+    
+    // Use bulk writes for default matrix layout. Register rows are packed into a
+    // fixed stack chunk (whole rows per chunk) so show() never touches the heap.
     uint8_t height = getHeight();
     uint8_t stride = getRegisterStride();
+    uint8_t rowsPerChunk = static_cast<uint8_t>(IS31FL373X_BULK_CHUNK_SIZE / stride);
+    if (rowsPerChunk == 0) return false;
     
-    // Calculate total register space needed (height * stride)
-    uint16_t hwBufferSize = height * stride;
-    
-#ifdef UNIT_TEST
-    uint8_t* hwBuffer = static_cast<uint8_t*>(std::malloc(hwBufferSize));
-    if (hwBuffer == nullptr) return;
-#else
-    // On real hardware, allocate on heap for large buffers
-    uint8_t* hwBuffer = new uint8_t[hwBufferSize];
-    if (hwBuffer == nullptr) return;
-#endif
-    
-    // Initialize to zero
-    memset(hwBuffer, 0, hwBufferSize);
+    uint8_t chunk[IS31FL373X_BULK_CHUNK_SIZE];
+    bool success = true;
+    for (uint8_t row = 0; row < height && success; row += rowsPerChunk) {
+        uint8_t rows = (height - row < rowsPerChunk) ? (height - row) : rowsPerChunk;
+        packRegisterRows(row, rows, chunk);
+        // Write packed rows using bulk I2C writes with auto-increment
+        success = writeBulk(static_cast<uint8_t>(row * stride), chunk, static_cast<size_t>(rows) * stride);
+    }
     
-    // Map logical buffer to hardware register layout
-    for (uint8_t row = 0; row < height; row++) {
+    return success;
+}
+
+void IS31FL373x_Device::packRegisterRows(uint8_t firstRow, uint8_t rowCount, uint8_t* out) {
+    // Map logical buffer rows to the hardware register layout (stride + chip quirks).
+    // Unused register slots (e.g. IS31FL3737 CS gaps) are sent as zero.
+    uint8_t width = getWidth();
+    uint8_t stride = getRegisterStride();
+    uint16_t base = static_cast<uint16_t>(firstRow) * stride;
+    uint16_t size = static_cast<uint16_t>(rowCount) * stride;
+    memset(out, 0, size);
+    // SW offsets shift logical rows down by whole register rows
+    int16_t rowStart = static_cast<int16_t>(firstRow) - _swOffset;
+    int16_t rowEnd = rowStart + rowCount;
+    if (rowStart < 0) rowStart = 0;
+    if (rowEnd > getHeight()) rowEnd = getHeight();
+    for (int16_t row = rowStart; row < rowEnd; row++) {
+        const uint8_t* srcRow = &_pwmBuffer[row * _bufferStride];
         for (uint8_t col = 0; col < width; col++) {
-            uint16_t bufferIndex = row * width + col;
             uint16_t regAddress = coordToIndex(col, row);
-            if (bufferIndex < getPWMBufferSize() && regAddress < hwBufferSize) {
-                hwBuffer[regAddress] = _pwmBuffer[bufferIndex];
+            if (regAddress >= base && regAddress < base + size) {
+                // Packed formats are expanded through the palette here, at flush time
+                if (_pixelFormat != PIXEL_FORMAT_8BIT) {
+                    out[regAddress - base] = flushValue(col, row);
+                } else {
+                    out[regAddress - base] = hasOutputTransform() ? scaleOutput(srcRow[col], outputGain(col, row))
+                                                                  : srcRow[col];
+                }
             }
         }
     }
-    
-    // Write entire buffer using bulk I2C writes with auto-increment
-    bool success = writeBulk(0x00, hwBuffer, hwBufferSize);
-    
-#ifdef UNIT_TEST
-    std::free(hwBuffer);
-#else
-    delete[] hwBuffer;
-#endif
-    
-    (void)success;  // Suppress unused variable warning in non-debug builds
 }
 
-void IS31FL373x_Device::clear() {
-    if (_pwmBuffer != nullptr) {
-        memset(_pwmBuffer, 0, getPWMBufferSize());
+// Reverse the bits of a byte: consecutive frame counts become maximally spread thresholds
+static uint8_t reverseBits(uint8_t value) {
+    value = static_cast<uint8_t>((value & 0xF0) >> 4 | (value & 0x0F) << 4);
+    value = static_cast<uint8_t>((value & 0xCC) >> 2 | (value & 0x33) << 2);
+    return static_cast<uint8_t>((value & 0xAA) >> 1 | (value & 0x55) << 1);
+}
+
+uint8_t IS31FL373x_Device::flushValue(uint8_t x, uint8_t y) {
+    if (_pixelFormat != PIXEL_FORMAT_16BIT) {
+        uint8_t value = loadPixel(x, y);
+        return hasOutputTransform() ? scaleOutput(value, outputGain(x, y)) : value;
+    }
+    const uint8_t* slot = &_pwmBuffer[y * _bufferStride + 2 * x];
+    uint16_t wide = static_cast<uint16_t>(slot[0] | (slot[1] << 8));
+    if (hasOutputTransform()) {
+        // Scale before dithering so the stretch keeps the fractional resolution
+        wide = static_cast<uint16_t>((static_cast<uint32_t>(wide) * outputGain(x, y)) >> 8);
     }
+    uint8_t level = static_cast<uint8_t>(wide >> 8);
+    uint8_t fraction = static_cast<uint8_t>(wide);
+    if (fraction == 0 || level == 255) return level;
+    _ditherRows |= static_cast<uint16_t>(1u << y);
+    // Over any 256 frames the LED is bumped up exactly `fraction` times. The per-LED
+    // offset keeps neighbours from stepping together, which would read as flicker.
+    uint8_t threshold = reverseBits(static_cast<uint8_t>(_ditherPhase + x * 29 + y * 71));
+    return (fraction > threshold) ? static_cast<uint8_t>(level + 1) : level;
+}
+
+void IS31FL373x_Device::clear() {
+    fillBufferRect(0, 0, getWidth(), getHeight(), 0);
 }
 
 void IS31FL373x_Device::setGlobalCurrent(uint8_t current) {
     _globalCurrent = current;
+    updateCurrentSplit();
     // Write to Global Current Control register on Function page
     selectPage(IS31FL373X_PAGE_FUNCTION);
-    writeRegister(0x01, current);
+    writeRegister(0x01, _appliedCurrent);
+}
+
+void IS31FL373x_Device::setOutputBrightness(uint8_t brightness) {
+    if (brightness == _outputBrightness) return;
+    _outputBrightness = brightness;
+    uint8_t previousCurrent = _appliedCurrent;
+    updateCurrentSplit();
+    if (_appliedCurrent != previousCurrent) {
+        selectPage(IS31FL373X_PAGE_FUNCTION);
+        writeRegister(0x01, _appliedCurrent);
+    }
+}
+
+void IS31FL373x_Device::updateCurrentSplit() {
+    // Smallest GCC covering current * brightness / 255, then the PWM stretch that
+    // lands the product exactly on the requested level (scale <= 1.0)
+    uint16_t target = static_cast<uint16_t>(_globalCurrent) * _outputBrightness;
+    uint8_t current = static_cast<uint8_t>((target + 254) / 255);
+    uint16_t scale = 256;
+    if (current > 0) {
+        scale = static_cast<uint16_t>((static_cast<uint32_t>(target) * 256 + (255u * current) / 2) /
+                                      (255u * current));
+    }
+    _appliedCurrent = current;
+    setFlushScales(scale, _limitScale);
+}
+
+void IS31FL373x_Device::setFlushScales(uint16_t outputScale, uint16_t limitScale) {
+    uint16_t flushScale = static_cast<uint16_t>((static_cast<uint32_t>(outputScale) * limitScale + 128) >> 8);
+    if (flushScale != _flushScale) markDirty();  // Every PWM value changes
+    _outputScale = outputScale;
+    _limitScale = limitScale;
+    _flushScale = flushScale;
+}
+
+uint32_t IS31FL373x_Device::estimateCurrent(uint16_t scale) const {
+    // 840 / R_ISET mA per LED at full GCC and PWM, in microamps
+    uint64_t numerator = 840000000ULL * _appliedCurrent * scale * getCalibratedPwmSum();
+    return static_cast<uint32_t>(numerator / (static_cast<uint64_t>(_isetOhms) << 24));
+}
+
+uint32_t IS31FL373x_Device::getEstimatedCurrent() const {
+    return estimateCurrent(_flushScale);
+}
+
+uint32_t IS31FL373x_Device::getPwmSum() const {
+    refreshPixelStats();
+    return _pwmSum;
+}
+
+uint32_t IS31FL373x_Device::getCalibratedPwmSum() const {
+    if (_calibration == nullptr || _pwmBuffer == nullptr) return getPwmSum();
+    // Tables may be edited in place, so the weighted sum is taken fresh on each query
+    uint32_t sum = 0;
+    for (uint8_t y = 0; y < getHeight(); y++) {
+        for (uint8_t x = 0; x < getWidth(); x++) {
+            uint8_t factor = _calibration[y * _calibrationStride + x];
+            sum += static_cast<uint32_t>(loadPixel(x, y)) * (factor + (factor >> 7));  // Same unit as outputGain()
+        }
+    }
+    return (sum + 128) >> 8;
+}
+
+void IS31FL373x_Device::refreshPixelStats() const {
+    if (tracksPixelStats()) return;
+    // Full rescan; afterwards the write paths keep the totals current
+    _pwmSum = 0;
+    _nonZeroCount = 0;
+#ifdef IS31FL373X_ENABLE_HISTOGRAM
+    memset(_histogram, 0, sizeof(_histogram));
+#endif
+    if (_pwmBuffer == nullptr) return;
+    for (uint8_t row = 0; row < getHeight(); row++) {
+        accountSpan(0, row, getWidth(), true);
+    }
+    _pixelStatsValid = true;
+}
+
+void IS31FL373x_Device::accountPixel(uint8_t oldValue, uint8_t newValue) const {
+    accountPixel16(static_cast<uint16_t>(oldValue) << 8, static_cast<uint16_t>(newValue) << 8);
+}
+
+void IS31FL373x_Device::accountPixel16(uint16_t oldValue, uint16_t newValue) const {
+    // Sums and histogram use whole levels; a fraction alone still lights the LED
+    // in some frames, so it counts as non-zero
+    _pwmSum += newValue >> 8;
+    _pwmSum -= oldValue >> 8;
+    _nonZeroCount = static_cast<uint16_t>(_nonZeroCount + (newValue != 0) - (oldValue != 0));
+#ifdef IS31FL373X_ENABLE_HISTOGRAM
+    _histogram[oldValue >> 12]--;
+    _histogram[newValue >> 12]++;
+#endif
+}
+
+void IS31FL373x_Device::accountSpan(uint8_t x, uint8_t y, uint16_t count, bool add) const {
+    // Read back through loadPixel so palette and CS-gap effects are counted exactly
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t value = loadPixel(static_cast<uint8_t>(x + i), y);
+        bool lit = (value != 0) ||
+                   (_pixelFormat == PIXEL_FORMAT_16BIT && _pwmBuffer[y * _bufferStride + 2 * (x + i)] != 0);
+        if (add) {
+            _pwmSum += value;
+            _nonZeroCount += lit;
+        } else {
+            _pwmSum -= value;
+            _nonZeroCount -= lit;
+        }
+#ifdef IS31FL373X_ENABLE_HISTOGRAM
+        _histogram[value >> 4] += add ? 1 : -1;
+#endif
+    }
+}
+
+void IS31FL373x_Device::setCalibration(const uint8_t* factors, uint16_t stride) {
+    _calibration = factors;
+    _calibrationStride = stride ? stride : getWidth();
+    markDirty();
+}
+
+uint16_t IS31FL373x_Device::outputGain(uint8_t x, uint8_t y) const {
+    if (_calibration == nullptr) return _flushScale;
+    // Calibration and the range stretch fold into one multiplier per LED
+    uint8_t factor = _calibration[y * _calibrationStride + x];
+    uint32_t unit = static_cast<uint32_t>(factor) + (factor >> 7);  // 255 -> 256 (1.0), no divide
+    return static_cast<uint16_t>((unit * _flushScale + 128) >> 8);
+}
+
+uint8_t IS31FL373x_Device::scaleOutput(uint8_t value, uint16_t gain) {
+    return static_cast<uint8_t>((static_cast<uint16_t>(value) * gain + 128) >> 8);
 }
 
 void IS31FL373x_Device::setMasterBrightness(uint8_t brightness) {
@@ -270,22 +828,464 @@ void IS31FL373x_Device::drawPixel(int16_t x, int16_t y, uint16_t color) {
         return;
     }
     
-    // Calculate buffer index (linear) - this is different from register address
-    uint16_t bufferIndex = y * getWidth() + x;
-    
-    if (bufferIndex < getPWMBufferSize() && _pwmBuffer != nullptr) {
+    // Calculate buffer offset (row pitch may exceed width when the buffer is
+    // a window into a caller-supplied framebuffer) - this is different from register address
+    if (_pwmBuffer != nullptr) {
         // Apply master brightness scaling
-        uint8_t scaledColor = (color * _masterBrightness) / 255;
-        _pwmBuffer[bufferIndex] = scaledColor;
+        storePixel(x, y, scaleColor(color));
+    }
+}
+
+void IS31FL373x_Device::drawPixel16(int16_t x, int16_t y, uint16_t value) {
+    if (x < 0 || y < 0 || x >= getWidth() || y >= getHeight() || _pwmBuffer == nullptr) {
+        return;
+    }
+    uint16_t scaled = static_cast<uint16_t>((static_cast<uint32_t>(value) * _masterBrightness) / 255);
+    if (_pixelFormat == PIXEL_FORMAT_16BIT) {
+        storePixel16(static_cast<uint8_t>(x), static_cast<uint8_t>(y), scaled);
+    } else {
+        storePixel(static_cast<uint8_t>(x), static_cast<uint8_t>(y), static_cast<uint8_t>(scaled >> 8));
+    }
+}
+
+void IS31FL373x_Device::writePixel(int16_t x, int16_t y, uint16_t color) {
+    drawPixel(x, y, color);
+}
+
+void IS31FL373x_Device::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillBufferRect(x, y, w, 1, scaleColor(color));
+}
+
+void IS31FL373x_Device::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillBufferRect(x, y, 1, h, scaleColor(color));
+}
+
+void IS31FL373x_Device::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    fillBufferRect(x, y, w, h, scaleColor(color));
+}
+
+void IS31FL373x_Device::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    fillBufferRect(x, y, w, 1, scaleColor(color));
+}
+
+void IS31FL373x_Device::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    fillBufferRect(x, y, 1, h, scaleColor(color));
+}
+
+void IS31FL373x_Device::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    fillBufferRect(x, y, w, h, scaleColor(color));
+}
+
+void IS31FL373x_Device::fillScreen(uint16_t color) {
+    fillBufferRect(0, 0, getWidth(), getHeight(), scaleColor(color));
+}
+
+uint8_t IS31FL373x_Device::scaleColor(uint16_t color) const {
+    // Same scaling as the per-pixel path; unsigned math avoids int16 overflow on AVR
+    return static_cast<uint8_t>((static_cast<uint32_t>(color) * _masterBrightness) / 255);
+}
+
+void IS31FL373x_Device::fillBufferRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t value) {
+    if (_pwmBuffer == nullptr) return;
+
+    // Normalize negative extents the way Adafruit_GFX canvases do
+    if (w < 0) { x += w + 1; w = -w; }
+    if (h < 0) { y += h + 1; h = -h; }
+
+    // Clip once against the matrix instead of per pixel
+    int16_t width = getWidth();
+    int16_t height = getHeight();
+    int16_t x0 = (x < 0) ? 0 : x;
+    int16_t y0 = (y < 0) ? 0 : y;
+    int16_t x1 = (x + w > width) ? width : x + w;
+    int16_t y1 = (y + h > height) ? height : y + h;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    uint16_t spanWidth = static_cast<uint16_t>(x1 - x0);
+    bool tracking = tracksPixelStats();
+    if (_pixelFormat != PIXEL_FORMAT_8BIT) {
+        for (int16_t row = y0; row < y1; row++) {
+            uint8_t rowX = static_cast<uint8_t>(x0);
+            uint8_t rowY = static_cast<uint8_t>(row);
+            if (tracking) accountSpan(rowX, rowY, spanWidth, false);
+            bool changed = false;
+            if (_pixelFormat == PIXEL_FORMAT_NATIVE) {
+                changed = fillNativeSpan(rowX, rowY, spanWidth, value);
+            } else if (_pixelFormat == PIXEL_FORMAT_16BIT) {
+                // 8-bit drawing stores whole levels, which never dither
+                uint8_t* slot = &_pwmBuffer[row * _bufferStride + 2 * x0];
+                for (uint16_t i = 0; i < spanWidth; i++, slot += 2) {
+                    changed |= (slot[0] != 0 || slot[1] != value);
+                    slot[0] = 0;
+                    slot[1] = value;
+                }
+            } else {
+                changed = fillPackedSpan(rowX, rowY, spanWidth, value);
+            }
+            if (tracking) accountSpan(rowX, rowY, spanWidth, true);
+            if (changed) markRows(rowY, static_cast<uint8_t>(rowY + 1));
+        }
+        return;
+    }
+    // Rows already holding the fill value stay clean, so clear() on a dark frame is free
+    for (int16_t row = y0; row < y1; row++) {
+        uint8_t* span = &_pwmBuffer[row * _bufferStride + x0];
+        bool changed = false;
+        for (uint16_t i = 0; i < spanWidth; i++) {
+            if (span[i] == value) continue;
+            changed = true;
+            if (tracking) accountPixel(span[i], value);
+        }
+        if (changed) markRows(static_cast<uint8_t>(row), static_cast<uint8_t>(row + 1));
+    }
+    if (spanWidth == static_cast<uint16_t>(width) && _bufferStride == spanWidth) {
+        // Full-width rows are contiguous in a packed buffer
+        memset(&_pwmBuffer[y0 * _bufferStride], value, static_cast<size_t>(y1 - y0) * width);
+        return;
+    }
+    for (int16_t row = y0; row < y1; row++) {
+        memset(&_pwmBuffer[row * _bufferStride + x0], value, spanWidth);
+    }
+}
+
+// Shared stamp counter for per-row dirty ages
+uint16_t IS31FL373x_Device::_dirtyClock = 0;
+
+void IS31FL373x_Device::markRows(uint8_t firstRow, uint8_t endRow) {
+    for (uint8_t row = firstRow; row < endRow && row < IS31FL373X_MAX_ROWS; row++) {
+        uint16_t bit = static_cast<uint16_t>(1u << row);
+        if (!(_dirtyRows & bit)) {
+            _dirtyRows |= bit;
+            _dirtySince[row] = _dirtyClock++;  // Staleness counts from the first unsent change
+        }
+    }
+}
+
+bool IS31FL373x_Device::fillNativeSpan(uint8_t x, uint8_t y, uint16_t count, uint8_t value) {
+    uint16_t regRow = static_cast<uint16_t>(y) + _swOffset;
+    if (regRow >= getHeight()) return false;
+    uint8_t* row = &_pwmBuffer[regRow * _bufferStride];
+    uint8_t stride = getRegisterStride();
+    uint8_t end = static_cast<uint8_t>(x + count);
+
+    // memset each run of register-contiguous columns; unused slots (CS gaps) stay zero
+    bool changed = false;
+    while (x < end) {
+        uint8_t first = _regColumn[x];
+        uint8_t runLength = 1;
+        while (x + runLength < end && _regColumn[x + runLength] == first + runLength) {
+            runLength++;
+        }
+        if (first < stride) {
+            for (uint8_t i = 0; i < runLength && !changed; i++) changed = (row[first + i] != value);
+            memset(&row[first], value, runLength);
+        }
+        x = static_cast<uint8_t>(x + runLength);
+    }
+    return changed;
+}
+
+bool IS31FL373x_Device::fillPackedSpan(uint8_t x, uint8_t y, uint16_t count, uint8_t value) {
+    uint8_t* row = &_pwmBuffer[y * _bufferStride];
+    uint8_t changed = 0;  // OR of old ^ new over every byte written
+    if (_pixelFormat == PIXEL_FORMAT_4BIT) {
+        uint8_t q = quantize4(value);
+        // Leading odd column, whole bytes (two pixels each), trailing even column
+        if ((x & 1) && count > 0) {
+            uint8_t next = static_cast<uint8_t>((row[x >> 1] & 0xF0) | q);
+            changed |= row[x >> 1] ^ next;
+            row[x >> 1] = next;
+            x++; count--;
+        }
+        if (count >= 2) {
+            uint8_t pair = static_cast<uint8_t>((q << 4) | q);
+            for (uint16_t i = 0; i < (count >> 1); i++) changed |= row[(x >> 1) + i] ^ pair;
+            memset(&row[x >> 1], pair, count >> 1);
+            x = static_cast<uint8_t>(x + (count & ~1u));
+            count &= 1;
+        }
+        if (count > 0) {
+            uint8_t next = static_cast<uint8_t>((row[x >> 1] & 0x0F) | (q << 4));
+            changed |= row[x >> 1] ^ next;
+            row[x >> 1] = next;
+        }
+        return changed != 0;
+    }
+    // PIXEL_FORMAT_1BIT: any non-zero value lights the LED
+    for (uint16_t i = 0; i < count; i++, x++) {
+        uint8_t mask = static_cast<uint8_t>(0x80 >> (x & 7));
+        uint8_t next = value ? (row[x >> 3] | mask) : (row[x >> 3] & static_cast<uint8_t>(~mask));
+        changed |= row[x >> 3] ^ next;
+        row[x >> 3] = next;
+    }
+    return changed != 0;
+}
+
+void IS31FL373x_Device::blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* src,
+                             uint16_t stride, BlitMode mode, uint8_t modeParam, bool scaleBrightness) {
+    if (_pwmBuffer == nullptr || src == nullptr || w <= 0 || h <= 0) return;
+    if (stride == 0) stride = static_cast<uint16_t>(w);
+
+    // Clip destination rectangle and advance the source origin to match
+    int16_t width = getWidth();
+    int16_t height = getHeight();
+    int16_t x0 = (x < 0) ? 0 : x;
+    int16_t y0 = (y < 0) ? 0 : y;
+    int16_t x1 = (x + w > width) ? width : x + w;
+    int16_t y1 = (y + h > height) ? height : y + h;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    uint16_t spanWidth = static_cast<uint16_t>(x1 - x0);
+    const uint8_t* srcRow = src + static_cast<size_t>(y0 - y) * stride + (x0 - x);
+
+    for (int16_t row = y0; row < y1; row++, srcRow += stride) {
+        if (_pixelFormat == PIXEL_FORMAT_8BIT && mode == BLIT_COPY && !scaleBrightness) {
+            uint8_t* dst = &_pwmBuffer[row * _bufferStride + x0];
+            if (memcmp(dst, srcRow, spanWidth) != 0) {
+                if (tracksPixelStats()) {
+                    for (uint16_t i = 0; i < spanWidth; i++) accountPixel(dst[i], srcRow[i]);
+                }
+                memcpy(dst, srcRow, spanWidth);
+                markRows(static_cast<uint8_t>(row), static_cast<uint8_t>(row + 1));
+            }
+            continue;
+        }
+        for (uint16_t i = 0; i < spanWidth; i++) {
+            uint8_t value = srcRow[i];
+            uint8_t col = static_cast<uint8_t>(x0 + i);
+            if (mode == BLIT_KEYED && value == modeParam) continue;
+            if (scaleBrightness) value = scaleColor(value);
+            if (mode == BLIT_ALPHA) {
+                uint8_t dst = loadPixel(col, static_cast<uint8_t>(row));
+                value = static_cast<uint8_t>((static_cast<uint16_t>(value) * modeParam +
+                                              static_cast<uint16_t>(dst) * (255 - modeParam)) / 255);
+            }
+            storePixel(col, static_cast<uint8_t>(row), value);
+        }
+    }
+}
+
+void IS31FL373x_Device::setPixel(uint16_t index, uint8_t pwm) {
+    if (index < getPWMBufferSize() && _pwmBuffer != nullptr) {
+        // Apply master brightness scaling; linear index is row-major over the matrix
+        storePixel(index % getWidth(), index / getWidth(), scaleColor(pwm));
+    }
+}
+
+uint8_t IS31FL373x_Device::loadPixel(uint8_t x, uint8_t y) const {
+    const uint8_t* row = &_pwmBuffer[y * _bufferStride];
+    switch (_pixelFormat) {
+        case PIXEL_FORMAT_4BIT:
+            return _palette[(row[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F];  // High nibble first
+        case PIXEL_FORMAT_1BIT:
+            return _palette[(row[x >> 3] >> (7 - (x & 7))) & 0x01];      // MSB first
+        case PIXEL_FORMAT_NATIVE: {
+            uint16_t offset = nativeOffset(x, y);
+            return (offset != 0xFFFF) ? _pwmBuffer[offset] : 0;
+        }
+        case PIXEL_FORMAT_16BIT:
+            return row[2 * x + 1];  // Whole level; the fraction only matters at flush time
+        default:
+            return row[x];
+    }
+}
+
+void IS31FL373x_Device::storePixel(uint8_t x, uint8_t y, uint8_t value) {
+    uint8_t* slot = nullptr;
+    if (_pixelFormat == PIXEL_FORMAT_8BIT) {
+        slot = &_pwmBuffer[y * _bufferStride + x];
+    } else if (_pixelFormat == PIXEL_FORMAT_NATIVE) {
+        uint16_t offset = nativeOffset(x, y);
+        if (offset == 0xFFFF) return;
+        slot = &_pwmBuffer[offset];
+    } else if (_pixelFormat == PIXEL_FORMAT_16BIT) {
+        storePixel16(x, y, static_cast<uint16_t>(value) << 8);
+        return;
+    } else {
+        uint8_t before = loadPixel(x, y);
+        if (!fillPackedSpan(x, y, 1, value)) return;  // Same stored level: row stays clean
+        if (tracksPixelStats()) accountPixel(before, loadPixel(x, y));
+        markRows(y, static_cast<uint8_t>(y + 1));
+        return;
+    }
+    if (*slot != value) {
+        if (tracksPixelStats()) accountPixel(*slot, value);
+        *slot = value;
+        markRows(y, static_cast<uint8_t>(y + 1));
+    }
+}
+
+void IS31FL373x_Device::storePixel16(uint8_t x, uint8_t y, uint16_t value) {
+    uint8_t* slot = &_pwmBuffer[y * _bufferStride + 2 * x];
+    uint8_t low = static_cast<uint8_t>(value);
+    uint8_t high = static_cast<uint8_t>(value >> 8);
+    if (slot[0] != low || slot[1] != high) {
+        if (tracksPixelStats()) accountPixel16(static_cast<uint16_t>((slot[1] << 8) | slot[0]), value);
+        slot[0] = low;
+        slot[1] = high;
+        markRows(y, static_cast<uint8_t>(y + 1));
+    }
+}
+
+uint16_t IS31FL373x_Device::nativeOffset(uint8_t x, uint8_t y) const {
+    // Cached column map + SW offset reproduce coordToIndex() without virtual calls
+    uint16_t regRow = static_cast<uint16_t>(y) + _swOffset;
+    uint8_t column = _regColumn[x];
+    if (column >= getRegisterStride() || regRow >= getHeight()) return 0xFFFF;
+    return static_cast<uint16_t>(regRow * _bufferStride + column);
+}
+
+void IS31FL373x_Device::rebuildRegisterMap() {
+    // Register column for each logical x, including CS offset and chip quirks
+    uint8_t stride = getRegisterStride();
+    for (uint8_t x = 0; x < 16; x++) {
+        uint16_t index = (x < getWidth()) ? coordToIndex(x, 0) : 0xFFFF;
+        if (index == 0xFFFF || index < static_cast<uint16_t>(_swOffset) * stride) {
+            _regColumn[x] = 0xFF;
+            continue;
+        }
+        uint16_t column = index - static_cast<uint16_t>(_swOffset) * stride;
+        _regColumn[x] = (column < stride) ? static_cast<uint8_t>(column) : 0xFF;
+    }
+}
+
+uint8_t IS31FL373x_Device::quantize4(uint8_t value) {
+    // Round to the nearest of the 16 default palette levels (n * 17)
+    return static_cast<uint8_t>((value + 8) / 17);
+}
+
+uint8_t IS31FL373x_Device::getBitsPerPixel() const {
+    switch (_pixelFormat) {
+        case PIXEL_FORMAT_4BIT: return 4;
+        case PIXEL_FORMAT_1BIT: return 1;
+        case PIXEL_FORMAT_16BIT: return 16;
+        default: return 8;
+    }
+}
+
+uint16_t IS31FL373x_Device::getRowBytes() const {
+    if (_pixelFormat == PIXEL_FORMAT_NATIVE) return getRegisterStride();
+    return static_cast<uint16_t>((getWidth() * getBitsPerPixel() + 7) / 8);
+}
+
+uint16_t IS31FL373x_Device::getBufferBytes() const {
+    return static_cast<uint16_t>(getHeight() * getRowBytes());
+}
+
+bool IS31FL373x_Device::setPixelFormat(PixelFormat format) {
+    if (format == _pixelFormat) return true;
+    if (_pwmBuffer != nullptr && !_ownsBuffer) return false;  // Caller sized the attached buffer
+
+    // Owned storage is re-created for the new format; contents are cleared. The new
+    // storage is obtained first, so a failure leaves the old format and buffer intact.
+    PixelFormat previous = _pixelFormat;
+    uint8_t* oldBuffer = _pwmBuffer;
+    uint16_t oldStride = _bufferStride;
+    _pixelFormat = format;
+    if (oldBuffer != nullptr) {
+        _pwmBuffer = nullptr;
+        if (!allocateBuffer()) {
+            _pixelFormat = previous;
+            _pwmBuffer = oldBuffer;
+            _bufferStride = oldStride;
+            _ownsBuffer = true;
+            return false;
+        }
+        uint8_t* newBuffer = _pwmBuffer;
+        uint16_t newStride = _bufferStride;
+        _pwmBuffer = oldBuffer;  // Free the old storage (a no-op for embedded storage)
+        releaseBuffer();
+        _pwmBuffer = newBuffer;
+        _bufferStride = newStride;
+        _ownsBuffer = true;
+    }
+    setDefaultPalette();
+    if (format == PIXEL_FORMAT_NATIVE) rebuildRegisterMap();
+    return true;
+}
+
+void IS31FL373x_Device::setPalette(const uint8_t* palette) {
+    if (palette == nullptr) {
+        setDefaultPalette();
+        markDirty();
+        _pixelStatsValid = false;
+        return;
+    }
+    uint8_t entries = (_pixelFormat == PIXEL_FORMAT_1BIT) ? 2 : 16;
+    memcpy(_palette, palette, entries);
+    markDirty();  // Expanded PWM values change even though stored indices do not
+    _pixelStatsValid = false;
+}
+
+void IS31FL373x_Device::setDefaultPalette() {
+    if (_pixelFormat == PIXEL_FORMAT_1BIT) {
+        _palette[0] = 0;
+        _palette[1] = 255;
+        return;
+    }
+    for (uint8_t i = 0; i < 16; i++) {
+        _palette[i] = static_cast<uint8_t>(i * 17);  // 0, 17, ... 255
+    }
+}
+
+bool IS31FL373x_Device::allocateBuffer() {
+#if defined(IS31FL373X_STATIC_ALLOCATION)
+    // Embedded storage is sized by the chip class for 8 bpp, no heap
+    if (getBufferBytes() > getEmbeddedBufferSize()) return false;
+    _pwmBuffer = getEmbeddedBuffer();
+#elif defined(UNIT_TEST)
+    _pwmBuffer = static_cast<uint8_t*>(std::malloc(getBufferBytes()));
+#else
+    _pwmBuffer = new uint8_t[getBufferBytes()];
+#endif
+    if (_pwmBuffer == nullptr) {
+        return false;
     }
+    _ownsBuffer = true;
+    _bufferStride = getRowBytes();
+    memset(_pwmBuffer, 0, getBufferBytes());
+    markDirty();
+    _pixelStatsValid = false;  // Index 0 may map to a non-zero palette entry
+    return true;
 }
 
-void IS31FL373x_Device::setPixel(uint16_t index, uint8_t pwm) {
-    if (index < getPWMBufferSize() && _pwmBuffer != nullptr) {
-        // Apply master brightness scaling
-        uint8_t scaledPWM = (pwm * _masterBrightness) / 255;
-        _pwmBuffer[index] = scaledPWM;
+bool IS31FL373x_Device::attachBuffer(uint8_t* buffer, size_t size, uint16_t stride) {
+    if (buffer == nullptr) {
+        // Detach; begin() will allocate an owned buffer again
+        releaseBuffer();
+        return true;
+    }
+    if (stride == 0) stride = getRowBytes();
+    if (stride < getRowBytes()) return false;
+    // A native buffer is sent verbatim, so it must be a contiguous register image
+    if (_pixelFormat == PIXEL_FORMAT_NATIVE && stride != getRowBytes()) return false;
+
+    // The last row only needs its own bytes, so windows may end flush with the buffer
+    size_t required = static_cast<size_t>(getHeight() - 1) * stride + getRowBytes();
+    if (size < required) return false;
+
+    releaseBuffer();
+    _pwmBuffer = buffer;
+    _bufferStride = stride;
+    _ownsBuffer = false;
+    markDirty();
+    return true;
+}
+
+void IS31FL373x_Device::releaseBuffer() {
+#ifndef IS31FL373X_STATIC_ALLOCATION
+    if (_pwmBuffer != nullptr && _ownsBuffer) {
+#ifdef UNIT_TEST
+        std::free(_pwmBuffer);
+#else
+        delete[] _pwmBuffer;
+#endif
     }
+#endif
+    _pwmBuffer = nullptr;
+    _bufferStride = 0;
+    _ownsBuffer = false;
+    _pixelStatsValid = false;
 }
 
 void IS31FL373x_Device::setLayout(const PixelMapEntry* layout, uint16_t layoutSize) {
@@ -315,73 +1315,210 @@ void IS31FL373x_Device::setLayout(const PixelMapEntry* layout, uint16_t layoutSi
     _customLayout = const_cast<PixelMapEntry*>(layout);
     _layoutSize = layoutSize;
     _useCustomLayout = true;
+    markDirty();
 }
 
 void IS31FL373x_Device::setCoordinateOffset(uint8_t csOffset, uint8_t swOffset) {
     _csOffset = csOffset;
     _swOffset = swOffset;
+    markDirty();  // Same pixels now land on different registers
+    if (_pixelFormat == PIXEL_FORMAT_NATIVE) {
+        rebuildRegisterMap();  // Existing native contents keep their old register slots
+        _pixelStatsValid = false;
+    }
 }
 
 bool IS31FL373x_Device::selectPage(uint8_t page) {
-    if (_i2c_dev == nullptr) return false;  // Not initialized yet
+    if (isBatching()) {
+        _batchPage = page;  // Selected for real when the queue is sent
+        return true;
+    }
+    // The command register holds its page, so re-selecting the active page can be skipped
+    if (_pageCaching && page == _currentPage) {
+        IS31FL373X_STAT(_stats.pageSelectsSkipped++);
+        return true;
+    }
+    _currentPage = IS31FL373X_PAGE_UNKNOWN;
+    IS31FL373X_TRACE(TRACE_PAGE_SELECT, true, _addr, page, 4);
     
     uint8_t buffer[2];
     
     // Unlock command register
     buffer[0] = IS31FL373X_REG_UNLOCK;
     buffer[1] = IS31FL373X_UNLOCK_VALUE;
-    if (!_i2c_dev->write(buffer, 2)) return false;
+    bool ok = busWrite(nullptr, 0, buffer, 2);
     
     // Select page
-    buffer[0] = IS31FL373X_REG_COMMAND;
-    buffer[1] = page;
-    return _i2c_dev->write(buffer, 2);
+    if (ok) {
+        buffer[0] = IS31FL373X_REG_COMMAND;
+        buffer[1] = page;
+        ok = busWrite(nullptr, 0, buffer, 2);
+    }
+    IS31FL373X_TRACE(TRACE_PAGE_SELECT, false, _addr, page, 4);
+    if (!ok) return false;
+    _currentPage = page;
+    IS31FL373X_STAT(_stats.pageSelects++);
+    return true;
 }
 
 bool IS31FL373x_Device::writeRegister(uint8_t reg, uint8_t value) {
-    if (_i2c_dev == nullptr) return false;  // Not initialized yet
+    if (isBatching()) {
+        if (queueWrite(reg, value)) return true;
+        // Sending it directly would overtake the writes still queued
+        _batchFailed = true;
+        return false;
+    }
     uint8_t buffer[2] = {reg, value};
-    return _i2c_dev->write(buffer, 2);
+    IS31FL373X_TRACE(TRACE_REGISTER_WRITE, true, _addr, reg, 1);
+    bool ok = busWrite(nullptr, 0, buffer, 2);
+    IS31FL373X_TRACE(TRACE_REGISTER_WRITE, false, _addr, reg, 1);
+    return ok;
+}
+
+bool IS31FL373x_Device::busWrite(const uint8_t* prefix, size_t prefixLen, const uint8_t* data, size_t length) {
+    if (_budgetFailed) return false;  // Budgeted frame already failed: send nothing more
+    if (_mux != nullptr && !_mux->select(_muxChannel)) {
+        _budgetFailed = _budgeted;
+        return false;
+    }
+    if (_transport == nullptr && _i2c_dev == nullptr) return false;  // Not initialized yet
+    uint8_t retries = _budgeted ? 0 : _retryLimit;
+    for (uint8_t attempt = 0; ; attempt++) {
+        bool ok = (_transport != nullptr) ? _transport->write(_addr, prefix, prefixLen, data, length)
+                                          : _i2c_dev->write(data, length, true, prefix, prefixLen);
+        IS31FL373X_STAT(_stats.transactions++; _stats.bytes += prefixLen + length; if (!ok) _stats.errors++);
+        if (ok) return true;
+        _errorCount++;
+        if (attempt >= retries) {
+            _budgetFailed = _budgeted;
+            return false;
+        }
+        _retryCount++;
+    }
 }
 
 bool IS31FL373x_Device::writeBulk(uint8_t startReg, const uint8_t* data, size_t length) {
-    if (_i2c_dev == nullptr || data == nullptr || length == 0) return false;
+    if (data == nullptr || length == 0) return false;
+    if (isBatching() && !closeBatch()) return false;  // Keep register order on the wire
     
     // I2C burst write: first byte is the starting register address,
     // followed by the data bytes. The chip will auto-increment the register address.
     // Maximum practical buffer size depends on I2C implementation, typically 128 bytes
-    const size_t MAX_CHUNK_SIZE = 64;  // Conservative chunk size for compatibility
+    const size_t MAX_CHUNK_SIZE = IS31FL373X_BULK_CHUNK_SIZE;
     
     size_t offset = 0;
     while (offset < length) {
         size_t chunkSize = (length - offset > MAX_CHUNK_SIZE) ? MAX_CHUNK_SIZE : (length - offset);
         
-#ifdef UNIT_TEST
-        // In unit tests, allocate on heap to avoid stack issues
-        uint8_t* buffer = static_cast<uint8_t*>(std::malloc(chunkSize + 1));
-        if (buffer == nullptr) return false;
-#else
-        // In real hardware, use VLA (variable length array) or allocate on heap
-        // For small chunks, stack allocation is fine
-        uint8_t buffer[MAX_CHUNK_SIZE + 1];
-#endif
-        
-        buffer[0] = startReg + offset;  // Starting register for this chunk
-        memcpy(&buffer[1], &data[offset], chunkSize);
-        
-        bool result = _i2c_dev->write(buffer, chunkSize + 1);
-        
-#ifdef UNIT_TEST
-        std::free(buffer);
-#endif
-        
-        if (!result) return false;
+        // The register address goes out as BusIO's prefix in the same transaction,
+        // so the payload is sent straight from the caller's buffer without staging
+        uint8_t reg = static_cast<uint8_t>(startReg + offset);
+        IS31FL373X_TRACE(TRACE_BULK_CHUNK, true, _addr, reg, static_cast<uint16_t>(chunkSize));
+        bool ok = busWrite(&reg, 1, &data[offset], chunkSize);
+        IS31FL373X_TRACE(TRACE_BULK_CHUNK, false, _addr, reg, static_cast<uint16_t>(chunkSize));
+        if (!ok) return false;
         offset += chunkSize;
     }
     
     return true;
 }
 
+// Register write queue, shared by all devices and owned by one batch at a time
+IS31FL373x_Device* IS31FL373x_Device::_batchOwner = nullptr;
+uint8_t IS31FL373x_Device::_batchDepth = 0;
+uint8_t IS31FL373x_Device::_queueLength = 0;
+IS31FL373x_Device::QueuedWrite IS31FL373x_Device::_queue[IS31FL373X_WRITE_QUEUE_SIZE];
+
+void IS31FL373x_Device::beginRegisterBatch() {
+    if (isBatching()) {
+        _batchDepth++;
+        return;
+    }
+    // One queue for all devices: another device's open batch goes out first
+    if (_batchOwner != nullptr) _batchOwner->closeBatch();
+    _batchOwner = this;
+    _batchDepth = 1;
+    _batchPage = _currentPage;
+}
+
+bool IS31FL373x_Device::commitRegisterBatch() {
+    if (isBatching()) {
+        if (--_batchDepth > 0) return true;
+        closeBatch();
+    }
+    // Also covers a batch already committed early (read, flush, another device)
+    bool ok = !_batchFailed;
+    _batchFailed = false;
+    return ok;
+}
+
+bool IS31FL373x_Device::closeBatch() {
+    bool ok = sendQueue();
+    _batchOwner = nullptr;
+    _batchDepth = 0;
+    return ok;
+}
+
+bool IS31FL373x_Device::queueWrite(uint8_t reg, uint8_t value) {
+    if (_batchPage == IS31FL373X_PAGE_UNKNOWN) return false;  // No page selected to queue it for
+    for (uint8_t i = 0; i < _queueLength; i++) {
+        if (_queue[i].page == _batchPage && _queue[i].reg == reg) {
+            _queue[i].value = value;
+            return true;
+        }
+    }
+    if (_queueLength == IS31FL373X_WRITE_QUEUE_SIZE && !sendQueue()) return false;
+    _queue[_queueLength].page = _batchPage;
+    _queue[_queueLength].reg = reg;
+    _queue[_queueLength].value = value;
+    _queueLength++;
+    return true;
+}
+
+bool IS31FL373x_Device::sendQueue() {
+    // Insertion sort by (page, reg); the queue is short
+    for (uint8_t i = 1; i < _queueLength; i++) {
+        QueuedWrite entry = _queue[i];
+        uint8_t j = i;
+        while (j > 0 && (_queue[j - 1].page > entry.page ||
+                         (_queue[j - 1].page == entry.page && _queue[j - 1].reg > entry.reg))) {
+            _queue[j] = _queue[j - 1];
+            j--;
+        }
+        _queue[j] = entry;
+    }
+    
+    // Send with queuing off, then restore it (a full queue flushes mid-batch)
+    IS31FL373x_Device* owner = _batchOwner;
+    _batchOwner = nullptr;
+    bool ok = true;
+    uint8_t values[IS31FL373X_WRITE_QUEUE_SIZE];
+    for (uint8_t start = 0; start < _queueLength;) {
+        uint8_t page = _queue[start].page;
+        uint8_t end = start + 1;
+        values[0] = _queue[start].value;
+        while (end < _queueLength && _queue[end].page == page &&
+               _queue[end].reg == _queue[end - 1].reg + 1) {
+            values[end - start] = _queue[end].value;
+            end++;
+        }
+        if (!selectPage(page)) {
+            ok = false;
+        } else if (end - start == 1) {
+            ok &= writeRegister(_queue[start].reg, values[0]);
+        } else {
+            ok &= writeBulk(_queue[start].reg, values, end - start);
+        }
+        start = end;
+    }
+    _queueLength = 0;
+    // Leave the chip on the page the caller last selected
+    if (_batchPage != IS31FL373X_PAGE_UNKNOWN && _batchPage != _currentPage) ok &= selectPage(_batchPage);
+    _batchOwner = owner;
+    if (!ok) _batchFailed = true;
+    return ok;
+}
+
 bool IS31FL373x_Device::isValidCsPin(uint8_t cs1Based) const {
     // Reference: doc/IS31FL373x-reference.md (matrix width per device)
     return (cs1Based >= 1) && (cs1Based <= getWidth());
@@ -396,13 +1533,21 @@ bool IS31FL373x_Device::isValidCsSw(uint8_t cs1Based, uint8_t sw1Based) const {
 }
 
 bool IS31FL373x_Device::readRegister(uint8_t reg, uint8_t* value) {
-    if (value == nullptr || _i2c_dev == nullptr) return false;
-    
-    // Write register address
-    if (!_i2c_dev->write(&reg, 1)) return false;
-    
-    // Read register value
-    return _i2c_dev->read(value, 1);
+    if (value == nullptr) return false;
+    if (isBatching() && !closeBatch()) return false;
+    if (_mux != nullptr && !_mux->select(_muxChannel)) return false;
+    bool ok;
+    if (_transport != nullptr) {
+        ok = _transport->read(_addr, reg, value, 1);
+    } else if (_i2c_dev != nullptr) {
+        // Write register address, then read register value
+        ok = _i2c_dev->write(&reg, 1) && _i2c_dev->read(value, 1);
+    } else {
+        return false;
+    }
+    IS31FL373X_STAT(_stats.transactions++; _stats.bytes += 2; if (!ok) _stats.errors++);
+    if (!ok) _errorCount++;
+    return ok;
 }
 
 uint16_t IS31FL373x_Device::coordToIndex(uint8_t x, uint8_t y) const {
@@ -435,43 +1580,45 @@ uint8_t IS31FL373x_Device::getPixelValue(uint16_t x, uint16_t y) const {
         return 0;
     }
     
-    uint16_t bufferIndex = y * getWidth() + x;
-    if (bufferIndex < getPWMBufferSize()) {
-        return _pwmBuffer[bufferIndex];
+    return loadPixel(x, y);
+}
+
+uint16_t IS31FL373x_Device::getPixelValue16(uint16_t x, uint16_t y) const {
+    if (x >= getWidth() || y >= getHeight() || _pwmBuffer == nullptr) {
+        return 0;
+    }
+    if (_pixelFormat == PIXEL_FORMAT_16BIT) {
+        const uint8_t* slot = &_pwmBuffer[y * _bufferStride + 2 * x];
+        return static_cast<uint16_t>(slot[0] | (slot[1] << 8));
     }
-    return 0;
+    return static_cast<uint16_t>(loadPixel(x, y)) << 8;
 }
 
 uint8_t IS31FL373x_Device::getPixelValueByIndex(uint16_t index) const {
     if (index >= getPWMBufferSize() || _pwmBuffer == nullptr) {
         return 0;
     }
-    return _pwmBuffer[index];
+    return loadPixel(index % getWidth(), index / getWidth());
 }
 
 uint16_t IS31FL373x_Device::getNonZeroPixelCount() const {
-    if (_pwmBuffer == nullptr) return 0;
-    
-    uint16_t count = 0;
-    uint16_t bufferSize = getPWMBufferSize();
-    for (uint16_t i = 0; i < bufferSize; i++) {
-        if (_pwmBuffer[i] > 0) {
-            count++;
-        }
-    }
-    return count;
+    refreshPixelStats();
+    return _nonZeroCount;
 }
 
 uint16_t IS31FL373x_Device::getPixelSum() const {
-    if (_pwmBuffer == nullptr) return 0;
-    
-    uint32_t sum = 0;  // Use 32-bit to avoid overflow
-    uint16_t bufferSize = getPWMBufferSize();
-    for (uint16_t i = 0; i < bufferSize; i++) {
-        sum += _pwmBuffer[i];
-    }
-    return (sum > 65535) ? 65535 : static_cast<uint16_t>(sum);  // Clamp to 16-bit
+    // One chip tops out at 192 * 255, so the 32-bit running sum always fits
+    refreshPixelStats();
+    return static_cast<uint16_t>(_pwmSum);
+}
+
+#ifdef IS31FL373X_ENABLE_HISTOGRAM
+uint16_t IS31FL373x_Device::getHistogramBin(uint8_t bin) const {
+    if (bin >= 16) return 0;
+    refreshPixelStats();
+    return _histogram[bin];
 }
+#endif
 
 // IS31FL3733 Implementation
 IS31FL3733::IS31FL3733(ADDR addr1, ADDR addr2, TwoWire *wire) 
@@ -591,13 +1738,171 @@ bool IS31FL373x_Canvas::begin() {
             success = false;
         }
     }
+    if (_clockPolicy.enabled()) applyBusClock();  // Range set before begin()
     return success;
 }
 
 void IS31FL373x_Canvas::show() {
+    applyCurrentLimit();
+    prepareDevices(true);
+    // Nothing changed anywhere: skip batching and mux selects too
+    if (!isDirty()) {
+        IS31FL373X_STAT(_stats.framesSkipped++);
+        updateSleep();
+        return;
+    }
+    
+    IS31FL373X_TRACE(TRACE_CANVAS_SHOW, true, 0, 0, _deviceCount);
+#ifdef IS31FL373X_ENABLE_STATS
+    unsigned long start = micros();
+#endif
+    flushGroups(false);
+#ifdef IS31FL373X_ENABLE_STATS
+    _stats.recordFlush(static_cast<uint32_t>(micros() - start));
+#endif
+    IS31FL373X_TRACE(TRACE_CANVAS_SHOW, false, 0, 0, _deviceCount);
+    updateSleep();
+    updateBusClock();
+}
+
+void IS31FL373x_Canvas::updateBusClock() {
+    if (_clockPolicy.enabled() && _clockPolicy.update(getErrorCount())) applyBusClock();
+}
+
+void IS31FL373x_Canvas::applyBusClock() {
     for (uint8_t i = 0; i < _deviceCount; i++) {
-        if (_devices[i] != nullptr) {
-            _devices[i]->show();
+        if (_devices[i] != nullptr) _devices[i]->applyBusClock(_clockPolicy.clockHz);
+    }
+}
+
+void IS31FL373x_Canvas::setRetryLimit(uint8_t retries) {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->setRetryLimit(retries);
+    }
+}
+
+void IS31FL373x_Canvas::setBusClockRange(uint32_t minHz, uint32_t maxHz) {
+    _clockPolicy.configure(minHz, maxHz, getErrorCount());
+    if (_clockPolicy.enabled()) applyBusClock();
+}
+
+uint32_t IS31FL373x_Canvas::getErrorCount() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) total += _devices[i]->getErrorCount();
+    }
+    return total;
+}
+
+void IS31FL373x_Canvas::prepareDevices(bool probe) {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        IS31FL373x_Device* device = _devices[i];
+        if (device == nullptr || device->_pwmBuffer == nullptr) continue;
+        if (probe) device->pollHealth();
+        device->trackDarkFrames();
+    }
+}
+
+void IS31FL373x_Canvas::setHealthCheckInterval(uint16_t frames) {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->setHealthCheckInterval(frames);
+    }
+}
+
+uint32_t IS31FL373x_Canvas::getResyncCount() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) total += _devices[i]->getResyncCount();
+    }
+    return total;
+}
+
+void IS31FL373x_Canvas::updateSleep() {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr && _devices[i]->_pwmBuffer != nullptr) _devices[i]->updateSleep();
+    }
+}
+
+void IS31FL373x_Canvas::setWarmStart(bool enable) {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->setWarmStart(enable);
+    }
+}
+
+void IS31FL373x_Canvas::setAutoSleep(uint8_t frames) {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->setAutoSleep(frames);
+    }
+}
+
+bool IS31FL373x_Canvas::showIncremental(uint16_t maxBytes) {
+    applyCurrentLimit();
+    prepareDevices(false);  // Probes and sleep/wake writes wait for show()
+    if (!isDirty()) {
+        IS31FL373X_STAT(_stats.framesSkipped++);
+        return true;
+    }
+    
+    // Spend the budget on the stalest rows of any device, then flush as usual
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->beginIncremental();
+    }
+    bool picked = false;
+    while (IS31FL373x_Device::pickStaleRow(_devices, _deviceCount, maxBytes)) {
+        picked = true;
+    }
+    if (!picked) return false;
+    
+    IS31FL373X_TRACE(TRACE_CANVAS_SHOW, true, 0, 0, _deviceCount);
+#ifdef IS31FL373X_ENABLE_STATS
+    unsigned long start = micros();
+#endif
+    flushGroups(true);
+#ifdef IS31FL373X_ENABLE_STATS
+    _stats.recordFlush(static_cast<uint32_t>(micros() - start));
+#endif
+    IS31FL373X_TRACE(TRACE_CANVAS_SHOW, false, 0, 0, _deviceCount);
+    updateBusClock();
+    return !isDirty();
+}
+
+void IS31FL373x_Canvas::flushGroups(bool incremental) {
+    // Let transports queue the whole frame; batches nest when devices share one
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr && _devices[i]->getTransport() != nullptr) {
+            _devices[i]->getTransport()->beginBatch();
+        }
+    }
+    // Flush devices grouped by mux path so each channel is opened once per frame.
+    // A device is handled by the first device of its group; no scratch storage needed.
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        bool seen = false;
+        for (uint8_t j = 0; j < i && !seen; j++) {
+            seen = (_devices[j] != nullptr) && sharesMuxPath(i, j);
+        }
+        if (seen) continue;
+        for (uint8_t k = i; k < _deviceCount; k++) {
+            IS31FL373x_Device* device = _devices[k];
+            if (device == nullptr || !sharesMuxPath(i, k)) continue;
+            if (!incremental) {
+                if (device->_pwmBuffer != nullptr) device->flushIfDirty();
+            } else if (device->_pendingRows != 0) {
+                device->flushPending();
+            }
+        }
+    }
+    // Nested endBatch() calls return true before anything is sent; only the outermost
+    // one knows whether the queued frame reached the bus. If it failed, the devices
+    // already cleared their dirty rows, so re-arm everyone on that transport.
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        IS31FL373x_Transport* transport = (_devices[i] != nullptr) ? _devices[i]->getTransport() : nullptr;
+        if (transport == nullptr || transport->endBatch()) continue;
+        _devices[i]->recordBatchError();
+        for (uint8_t k = 0; k < _deviceCount; k++) {
+            if (_devices[k] == nullptr || _devices[k]->getTransport() != transport) continue;
+            _devices[k]->forgetBusState();
+            _devices[k]->markDirty();
         }
     }
 }
@@ -618,6 +1923,14 @@ void IS31FL373x_Canvas::setGlobalCurrent(uint8_t current) {
     }
 }
 
+void IS31FL373x_Canvas::setOutputBrightness(uint8_t brightness) {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) {
+            _devices[i]->setOutputBrightness(brightness);
+        }
+    }
+}
+
 void IS31FL373x_Canvas::setMasterBrightness(uint8_t brightness) {
     for (uint8_t i = 0; i < _deviceCount; i++) {
         if (_devices[i] != nullptr) {
@@ -634,13 +1947,128 @@ void IS31FL373x_Canvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
     }
 }
 
+void IS31FL373x_Canvas::drawPixel16(int16_t x, int16_t y, uint16_t value) {
+    int16_t localX, localY;
+    IS31FL373x_Device* device = getDeviceForCoordinate(x, y, &localX, &localY);
+    if (device != nullptr) {
+        device->drawPixel16(localX, localY, value);
+    }
+}
+
+void IS31FL373x_Canvas::blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* src,
+                             uint16_t stride, BlitMode mode, uint8_t modeParam, bool scaleBrightness) {
+    if (src == nullptr || w <= 0 || h <= 0) return;
+    if (stride == 0) stride = static_cast<uint16_t>(w);
+
+    // Hand each device the whole rectangle in its local coordinates; the device
+    // clips it to its own window so only the overlapping rows are copied.
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        int16_t originX, originY;
+        getDeviceOrigin(i, &originX, &originY);
+        _devices[i]->blit(x - originX, y - originY, w, h, src, stride, mode, modeParam, scaleBrightness);
+    }
+}
+
+bool IS31FL373x_Canvas::attachBuffer(uint8_t* buffer, size_t size) {
+    uint16_t canvasWidth = static_cast<uint16_t>(width());
+    if (buffer == nullptr || size < static_cast<size_t>(canvasWidth) * height()) return false;
+
+    // Validate every window before rebinding anything so a bad layout leaves devices untouched
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        if (_devices[i]->getPixelFormat() != PIXEL_FORMAT_8BIT) return false;  // Byte-per-pixel only
+        int16_t originX, originY;
+        getDeviceOrigin(i, &originX, &originY);
+        if (originX + _devices[i]->getWidth() > canvasWidth ||
+            originY + _devices[i]->getHeight() > height()) {
+            return false;
+        }
+    }
+
+    // Each device views its slice of the canvas framebuffer with the canvas row pitch
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        int16_t originX, originY;
+        getDeviceOrigin(i, &originX, &originY);
+        size_t offset = static_cast<size_t>(originY) * canvasWidth + originX;
+        _devices[i]->attachBuffer(buffer + offset, size - offset, canvasWidth);
+    }
+    return true;
+}
+
+void IS31FL373x_Canvas::setCurrentBudget(uint32_t microamps) {
+    _currentBudget = microamps;
+    applyCurrentLimit();
+}
+
+uint32_t IS31FL373x_Canvas::getEstimatedCurrent() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) total += _devices[i]->getEstimatedCurrent();
+    }
+    return total;
+}
+
+void IS31FL373x_Canvas::applyCurrentLimit() {
+    // Estimate the frame as it would go out unlimited; one shared factor keeps the
+    // relative brightness of the devices intact
+    uint16_t limit = 256;
+    if (_currentBudget > 0) {
+        uint32_t unlimited = 0;
+        for (uint8_t i = 0; i < _deviceCount; i++) {
+            if (_devices[i] != nullptr) unlimited += _devices[i]->estimateCurrent(_devices[i]->_outputScale);
+        }
+        if (unlimited > _currentBudget) {
+            limit = static_cast<uint16_t>((static_cast<uint64_t>(_currentBudget) * 256) / unlimited);
+        }
+    }
+    _limitScale = limit;
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->setFlushScales(_devices[i]->_outputScale, limit);
+    }
+}
+
+bool IS31FL373x_Canvas::setCalibration(const uint8_t* factors) {
+    uint16_t canvasWidth = static_cast<uint16_t>(width());
+    // Each device reads its window of the canvas table, like attachBuffer()
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        int16_t originX, originY;
+        getDeviceOrigin(i, &originX, &originY);
+        if (originX + _devices[i]->getWidth() > canvasWidth ||
+            originY + _devices[i]->getHeight() > height()) {
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        if (factors == nullptr) {
+            _devices[i]->setCalibration(nullptr);
+            continue;
+        }
+        int16_t originX, originY;
+        getDeviceOrigin(i, &originX, &originY);
+        _devices[i]->setCalibration(factors + static_cast<size_t>(originY) * canvasWidth + originX, canvasWidth);
+    }
+    return true;
+}
+
 void IS31FL373x_Canvas::identifyDevices() {
     // TODO: Implement device identification sequence
     // For now, just a placeholder
 }
 
-uint16_t IS31FL373x_Canvas::getTotalNonZeroPixelCount() const {
-    uint16_t totalCount = 0;
+uint32_t IS31FL373x_Canvas::getTotalPixelSum() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) total += _devices[i]->getPwmSum();
+    }
+    return total;
+}
+
+uint32_t IS31FL373x_Canvas::getTotalNonZeroPixelCount() const {
+    uint32_t totalCount = 0;
     for (uint8_t i = 0; i < _deviceCount; i++) {
         if (_devices[i] != nullptr) {
             totalCount += _devices[i]->getNonZeroPixelCount();
@@ -686,3 +2114,139 @@ IS31FL373x_Device* IS31FL373x_Canvas::getDeviceForCoordinate(int16_t x, int16_t
     }
     return nullptr;
 }
+
+void IS31FL373x_Canvas::getDeviceOrigin(uint8_t index, int16_t* originX, int16_t* originY) const {
+    // Origins follow the same cumulative slicing as getDeviceForCoordinate()
+    int16_t cursor = 0;
+    for (uint8_t i = 0; i < index && i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        cursor += (_layout == LAYOUT_VERTICAL) ? _devices[i]->getHeight() : _devices[i]->getWidth();
+    }
+    *originX = (_layout == LAYOUT_VERTICAL) ? 0 : cursor;
+    *originY = (_layout == LAYOUT_VERTICAL) ? cursor : 0;
+}
+
+#ifdef IS31FL373X_ENABLE_STATS
+IS31FL373x_Stats IS31FL373x_Canvas::getStats() const {
+    IS31FL373x_Stats total = _stats;
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] == nullptr) continue;
+        const IS31FL373x_Stats& device = _devices[i]->getStats();
+        total.bytes += device.bytes;
+        total.transactions += device.transactions;
+        total.pageSelects += device.pageSelects;
+        total.pageSelectsSkipped += device.pageSelectsSkipped;
+        total.errors += device.errors;
+    }
+    return total;
+}
+
+void IS31FL373x_Canvas::resetStats() {
+    _stats.reset();
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->resetStats();
+    }
+}
+#endif
+
+bool IS31FL373x_Canvas::isDirty() const {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr && _devices[i]->isDirty()) return true;
+    }
+    return false;
+}
+
+void IS31FL373x_Canvas::markDirty() {
+    for (uint8_t i = 0; i < _deviceCount; i++) {
+        if (_devices[i] != nullptr) _devices[i]->markDirty();
+    }
+}
+
+bool IS31FL373x_Canvas::sharesMuxPath(uint8_t a, uint8_t b) const {
+    const IS31FL373x_Device* first = _devices[a];
+    const IS31FL373x_Device* second = _devices[b];
+    if (first->getMux() != second->getMux()) return false;
+    return first->getMux() == nullptr || first->getMuxChannel() == second->getMuxChannel();
+}
+
+// Wire Transport Implementation
+bool IS31FL373x_WireTransport::write(uint8_t addr, const uint8_t* prefix, size_t prefixLen,
+                                     const uint8_t* data, size_t length) {
+    // Adafruit_I2CDevice only stores the address; constructing one per call is free
+    Adafruit_I2CDevice device(addr, _wire);
+    return device.write(data, length, true, prefix, prefixLen);
+}
+
+bool IS31FL373x_WireTransport::read(uint8_t addr, uint8_t reg, uint8_t* data, size_t length) {
+    Adafruit_I2CDevice device(addr, _wire);
+    return device.write(&reg, 1) && device.read(data, length);
+}
+
+// Multiplexer Implementation
+const uint8_t IS31FL373x_Mux::NO_CHANNEL;
+IS31FL373x_Mux* IS31FL373x_Mux::_first = nullptr;
+
+IS31FL373x_Mux::IS31FL373x_Mux(uint8_t addr, TwoWire *wire)
+    : _addr(addr), _wire(wire), _i2c(addr, wire), _transport(nullptr),
+      _selected(NO_CHANNEL), _known(false), _selectWrites(0), _next(_first) {
+    _first = this;
+}
+
+IS31FL373x_Mux::~IS31FL373x_Mux() {
+    for (IS31FL373x_Mux** link = &_first; *link != nullptr; link = &(*link)->_next) {
+        if (*link == this) {
+            *link = _next;
+            break;
+        }
+    }
+}
+
+bool IS31FL373x_Mux::begin() {
+    if (_transport == nullptr && !_i2c.begin()) return false;
+    return writeControl(0x00);
+}
+
+bool IS31FL373x_Mux::select(uint8_t channel) {
+    if (channel > 7) return false;
+    if (_known && _selected == channel) return true;
+    
+    // Chips behind another mux may share addresses with ours: close that mux first
+    for (IS31FL373x_Mux* other = _first; other != nullptr; other = other->_next) {
+        if (other != this && sharesBusWith(*other) && (!other->_known || other->_selected != NO_CHANNEL)) {
+            if (!other->deselect()) return false;
+        }
+    }
+    if (!writeControl(static_cast<uint8_t>(1 << channel))) return false;
+    _selected = channel;
+    return true;
+}
+
+void IS31FL373x_Mux::invalidateAll(IS31FL373x_Transport* transport) {
+    for (IS31FL373x_Mux* mux = _first; mux != nullptr; mux = mux->_next) {
+        if (mux->_transport == transport) mux->invalidate();
+    }
+}
+
+uint8_t IS31FL373x_Mux::getMaxSelectBytes() const {
+    // Address + control byte for our select, plus one deselect per sibling on the bus
+    uint8_t bytes = 2;
+    for (const IS31FL373x_Mux* other = _first; other != nullptr; other = other->_next) {
+        if (other != this && sharesBusWith(*other)) bytes = static_cast<uint8_t>(bytes + 2);
+    }
+    return bytes;
+}
+
+bool IS31FL373x_Mux::deselect() {
+    if (_known && _selected == NO_CHANNEL) return true;
+    return writeControl(0x00);
+}
+
+bool IS31FL373x_Mux::writeControl(uint8_t mask) {
+    _selectWrites++;
+    bool ok = (_transport != nullptr) ? _transport->write(_addr, nullptr, 0, &mask, 1)
+                                      : _i2c.write(&mask, 1);
+    // On failure the mux state is unknown, so the next select() writes it again
+    _known = ok;
+    _selected = NO_CHANNEL;
+    return ok;
+}
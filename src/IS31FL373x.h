@@ -17,6 +17,9 @@ struct MockI2COperation {
 };
 
 extern std::vector<MockI2COperation> mockI2COperations;
+extern unsigned long mockMicros;  // Mock clock; each mock I2C byte advances it by 25 us
+extern uint32_t mockBusClock;     // Last clock set through TwoWire::setClock()/setSpeed()
+unsigned long micros();
 void clearMockI2COperations();
 size_t getMockI2COperationCount();
 bool mockI2CContainsWrite(uint8_t reg, uint8_t value);
@@ -25,6 +28,9 @@ bool mockI2CContainsWrite(uint8_t reg, uint8_t value);
 class TwoWire {
 public:
     static TwoWire& getInstance() { static TwoWire instance; return instance; }
+    void begin() { begun = true; }
+    void setClock(uint32_t hz) { mockBusClock = hz; }
+    bool begun = false;
 };
 extern TwoWire Wire;
 
@@ -35,13 +41,20 @@ public:
     virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
     int16_t width() const { return _width; }
     int16_t height() const { return _height; }
-    // Minimal subset of Adafruit_GFX primitives for UNIT_TEST
-    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    // Minimal subset of Adafruit_GFX primitives for UNIT_TEST.
+    // Virtual dispatch mirrors upstream so subclasses can override spans.
+    virtual void startWrite() {}
+    virtual void endWrite() {}
+    virtual void writePixel(int16_t x, int16_t y, uint16_t color) { drawPixel(x, y, color); }
+    virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { drawFastHLine(x, y, w, color); }
+    virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { drawFastVLine(x, y, h, color); }
+    virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRect(x, y, w, h, color); }
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
         for (int16_t i = 0; i < w; i++) {
             drawPixel(x + i, y, color);
         }
     }
-    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
         for (int16_t i = 0; i < h; i++) {
             drawPixel(x, y + i, color);
         }
@@ -55,11 +68,12 @@ public:
             if (w > 1) drawFastVLine(x + w - 1, y + 1, h - 2, color);
         }
     }
-    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
         for (int16_t j = 0; j < h; j++) {
             drawFastHLine(x, y + j, w, color);
         }
     }
+    virtual void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
 protected:
     int16_t _width, _height;
 };
@@ -69,7 +83,9 @@ public:
     Adafruit_I2CDevice(uint8_t addr, TwoWire* wire = nullptr) : _addr(addr), _wire(wire), _lastReg(0) {}
     virtual ~Adafruit_I2CDevice() = default;
     bool begin() { return true; }
-    bool write(uint8_t* buffer, size_t len);
+    bool setSpeed(uint32_t desiredclk) { mockBusClock = desiredclk; return true; }
+    bool write(const uint8_t* buffer, size_t len, bool stop = true,
+               const uint8_t* prefix_buffer = nullptr, size_t prefix_len = 0);
     bool read(uint8_t* buffer, size_t len) {
         (void)buffer; (void)len;
         // Track I2C read operations during UNIT_TESTs
@@ -96,6 +112,17 @@ private:
 #include <Adafruit_I2CDevice.h>
 #endif
 
+// Build option: IS31FL373X_STATIC_ALLOCATION embeds the I2C device object and the
+// PWM buffer in each device instance, so begin()/show() never touch the heap and
+// RAM use is fixed at link time. Define it globally (e.g. in build_flags).
+#ifdef IS31FL373X_STATIC_ALLOCATION
+#if defined(__AVR__)
+#include <new.h>  // Placement new on AVR cores
+#else
+#include <new>
+#endif
+#endif
+
 // Version
 #define IS31FL373X_VERSION "1.0.11"
 
@@ -124,6 +151,94 @@ enum class ADDR {
 #define IS31FL373X_PAGE_PWM        0x01
 #define IS31FL373X_PAGE_ABM        0x02
 #define IS31FL373X_PAGE_FUNCTION   0x03
+#define IS31FL373X_PAGE_UNKNOWN    0xFF  // Page register state not known (before begin/after reset)
+
+#define IS31FL373X_MAX_ROWS        12      // Logical rows of the tallest supported chip
+#define IS31FL373X_ALL_ROWS        0x0FFF  // Dirty-row mask covering every row
+
+// Largest I2C burst payload per transaction (register address byte excluded).
+// Override with a smaller value (>= 16) for cores with small Wire buffers.
+#ifndef IS31FL373X_BULK_CHUNK_SIZE
+#define IS31FL373X_BULK_CHUNK_SIZE 64
+#endif
+
+// Register writes queued between beginRegisterBatch() and commitRegisterBatch().
+// One queue is shared by all devices (3 bytes per entry); a full queue is sent early.
+#ifndef IS31FL373X_WRITE_QUEUE_SIZE
+#define IS31FL373X_WRITE_QUEUE_SIZE 32
+#endif
+
+// Adaptive bus clock: the clock is halved when at least ERROR_THRESHOLD transactions
+// fail within CLOCK_WINDOW flushed frames, and doubled after a window without failures.
+#ifndef IS31FL373X_CLOCK_WINDOW
+#define IS31FL373X_CLOCK_WINDOW 64
+#endif
+#ifndef IS31FL373X_CLOCK_ERROR_THRESHOLD
+#define IS31FL373X_CLOCK_ERROR_THRESHOLD 2
+#endif
+
+struct IS31FL373x_ClockPolicy {
+    uint32_t minHz = 0;
+    uint32_t maxHz = 0;              // 0 = policy disabled
+    uint32_t clockHz = 0;            // Clock currently applied
+    uint16_t windowFrames = 0;
+    uint32_t windowStartErrors = 0;  // Error total when the window opened
+    
+    bool enabled() const { return maxHz != 0; }
+    void configure(uint32_t minClock, uint32_t maxClock, uint32_t errors);
+    bool update(uint32_t errors);    // Once per flushed frame; true when clockHz changed
+};
+
+// Build option: IS31FL373X_ENABLE_STATS adds bus and flush counters to devices
+// and the canvas. Without it the counters and their accessors are compiled out.
+#ifdef IS31FL373X_ENABLE_STATS
+struct IS31FL373x_Stats {
+    uint32_t frames;              // Completed show() calls
+    uint32_t framesSkipped;       // show() calls that returned early because nothing changed
+    uint32_t bytes;               // Bytes on the wire, register prefixes included
+    uint32_t transactions;        // I2C transactions issued
+    uint32_t pageSelects;         // Page selects sent to the chip
+    uint32_t pageSelectsSkipped;  // Page selects avoided because the page was already active
+    uint32_t errors;              // Failed transactions
+    uint32_t minFlushMicros;
+    uint32_t maxFlushMicros;
+    uint32_t totalFlushMicros;
+    
+    IS31FL373x_Stats() { reset(); }
+    void reset() { memset(this, 0, sizeof(*this)); }
+    uint32_t getAverageFlushMicros() const { return frames ? totalFlushMicros / frames : 0; }
+    void recordFlush(uint32_t elapsed) {
+        minFlushMicros = (frames == 0 || elapsed < minFlushMicros) ? elapsed : minFlushMicros;
+        maxFlushMicros = (elapsed > maxFlushMicros) ? elapsed : maxFlushMicros;
+        totalFlushMicros += elapsed;
+        frames++;
+    }
+};
+#endif
+
+// Build option: IS31FL373X_ENABLE_TRACE calls a global hook on entry and exit of
+// show(), page selects, register writes and each bulk chunk. Compiled out by default.
+#ifdef IS31FL373X_ENABLE_TRACE
+enum IS31FL373x_TraceEvent {
+    TRACE_CANVAS_SHOW,    // IS31FL373x_Canvas::show() (addr 0)
+    TRACE_SHOW,           // IS31FL373x_Device::show()
+    TRACE_PAGE_SELECT,    // reg = page (only selects actually sent)
+    TRACE_REGISTER_WRITE, // reg = register
+    TRACE_BULK_CHUNK      // reg = first register, length = payload bytes
+};
+
+struct IS31FL373x_TraceRecord {
+    IS31FL373x_TraceEvent event;
+    bool begin;           // true on entry, false on exit
+    uint8_t addr;         // 7-bit chip address
+    uint8_t reg;
+    uint16_t length;
+    uint32_t micros;      // micros() when the hook fired
+};
+
+typedef void (*IS31FL373x_TraceHook)(const IS31FL373x_TraceRecord& record, void* context);
+void IS31FL373x_setTraceHook(IS31FL373x_TraceHook hook, void* context = nullptr);  // nullptr disables
+#endif
 
 // Pixel mapping structure for custom layouts
 struct PixelMapEntry {
@@ -131,6 +246,107 @@ struct PixelMapEntry {
     uint8_t sw;  // Switch/Row pin (1-12 for both)
 };
 
+// Storage formats for the device PWM buffer. Packed formats trade gradation for
+// RAM and are expanded to 8-bit PWM through a small palette when flushed.
+enum PixelFormat {
+    PIXEL_FORMAT_8BIT,  // One byte per LED (default)
+    PIXEL_FORMAT_4BIT,  // Two LEDs per byte, 16-entry palette
+    PIXEL_FORMAT_1BIT,  // Eight LEDs per byte, on/off for monochrome segment displays
+    PIXEL_FORMAT_NATIVE, // One byte per LED laid out as the PWM register image (stride 16,
+                         // CS gaps included) so show() sends it without any packing
+    PIXEL_FORMAT_16BIT   // Two bytes per LED (8.8 fixed point, low byte first); the fraction
+                         // is rendered by temporal dithering across show() calls
+};
+
+// Compositing modes for blit()
+enum BlitMode {
+    BLIT_COPY,   // Overwrite destination (row memcpy when unscaled)
+    BLIT_KEYED,  // Skip source pixels equal to the key value
+    BLIT_ALPHA   // Blend source over destination with a constant alpha (0-255)
+};
+
+/**
+ * Optional bus backend for a device
+ * Devices talk through Adafruit_I2CDevice unless a transport is set. Writes issued
+ * between beginBatch() and endBatch() may be queued and sent together; batches nest,
+ * so devices sharing one transport flush when the outermost endBatch() runs.
+ */
+class IS31FL373x_Transport {
+public:
+    virtual ~IS31FL373x_Transport() = default;
+    // One write transaction: prefix bytes (register address) followed by data
+    virtual bool write(uint8_t addr, const uint8_t* prefix, size_t prefixLen,
+                       const uint8_t* data, size_t length) = 0;
+    // Send the register address, then read length bytes
+    virtual bool read(uint8_t addr, uint8_t reg, uint8_t* data, size_t length) = 0;
+    virtual void beginBatch() {}
+    virtual bool endBatch() { return true; }  // False if any deferred write failed
+    virtual bool setClock(uint32_t hz) { (void)hz; return false; }  // False if the bus clock is fixed
+};
+
+/**
+ * Transport over Adafruit_I2CDevice on a TwoWire bus
+ * Same bus traffic as the default device path, for use where a transport is
+ * required (e.g. as the inner transport of IS31FL373x_CaptureTransport).
+ */
+class IS31FL373x_WireTransport : public IS31FL373x_Transport {
+public:
+    explicit IS31FL373x_WireTransport(TwoWire *wire = &Wire) : _wire(wire) {}
+    // Devices skip Adafruit_I2CDevice::begin() when a transport is set, so the bus
+    // is initialised here instead; call once before the devices' begin()
+    void begin() { _wire->begin(); }
+    bool write(uint8_t addr, const uint8_t* prefix, size_t prefixLen,
+               const uint8_t* data, size_t length) override;
+    bool read(uint8_t addr, uint8_t reg, uint8_t* data, size_t length) override;
+    bool setClock(uint32_t hz) override { _wire->setClock(hz); return true; }
+
+private:
+    TwoWire* _wire;
+};
+
+/**
+ * TCA9548A-style I2C multiplexer
+ * Lets more than 16 chips share a bus: each device sits behind a (mux, channel)
+ * path. The selected channel is cached, so devices on an already-open channel
+ * cost no extra writes; opening a channel closes any other mux on the same bus.
+ */
+class IS31FL373x_Mux {
+public:
+    static const uint8_t NO_CHANNEL = 0xFF;
+    
+    IS31FL373x_Mux(uint8_t addr = 0x70, TwoWire *wire = &Wire);
+    ~IS31FL373x_Mux();
+    
+    bool begin();                        // Close all channels
+    bool select(uint8_t channel);        // 0-7; no bus traffic if already selected
+    bool deselect();                     // Close all channels
+    void invalidate() { _selected = NO_CHANNEL; _known = false; }  // Forget cached state (e.g. after mux reset)
+    void setTransport(IS31FL373x_Transport* transport) { _transport = transport; _known = false; }
+    static void invalidateAll(IS31FL373x_Transport* transport);  // Every mux writing through transport
+    
+    // State inspection methods for testing
+    uint8_t getSelectedChannel() const { return _selected; }
+    uint8_t getI2CAddress() const { return _addr; }
+    uint32_t getSelectWriteCount() const { return _selectWrites; }
+    uint8_t getMaxSelectBytes() const;   // Worst case for select(): sibling deselects included
+
+private:
+    uint8_t _addr;
+    TwoWire* _wire;
+    Adafruit_I2CDevice _i2c;
+    IS31FL373x_Transport* _transport;
+    uint8_t _selected;
+    bool _known;                // False until the control register state is known
+    uint32_t _selectWrites;
+    IS31FL373x_Mux* _next;      // Registry of muxes, to close siblings on the same bus
+    static IS31FL373x_Mux* _first;
+    
+    bool writeControl(uint8_t mask);
+    bool sharesBusWith(const IS31FL373x_Mux& other) const {
+        return _wire == other._wire && _transport == other._transport;
+    }
+};
+
 // Canvas layout options
 enum CanvasLayout {
     LAYOUT_HORIZONTAL,
@@ -165,26 +381,235 @@ public:
     void setGlobalCurrent(uint8_t current);
     void setMasterBrightness(uint8_t brightness);
     
+    // Overall brightness split between global current and PWM (255 = full). GCC is
+    // lowered to the smallest value that covers the level and PWM values are stretched
+    // back up in show(), so dimming keeps the full PWM gradation instead of discarding
+    // low bits. setGlobalCurrent() sets the current used at full brightness.
+    void setOutputBrightness(uint8_t brightness);
+    uint8_t getOutputBrightness() const { return _outputBrightness; }
+    
+    // Per-LED brightness correction applied in show() (255 = unchanged, 128 = half).
+    // The table is caller-owned, row-major over the logical matrix with the given
+    // row pitch (0 = width), and is not copied; call markDirty() after editing it.
+    // nullptr disables correction.
+    void setCalibration(const uint8_t* factors, uint16_t stride = 0);
+    const uint8_t* getCalibration() const { return _calibration; }
+    
+    // Power model from the datasheet: LED current = 840 / R_ISET x GCC/256 x PWM/256.
+    // The PWM sum is kept up to date by the pixel write paths, so estimates are O(1)
+    // (attached buffers are rescanned, since they can change behind the driver's back).
+    // With a calibration table the estimate weights each LED by its factor, one pass per query.
+    void setCurrentSetResistor(uint32_t ohms) { if (ohms > 0) _isetOhms = ohms; }  // R_ISET, default 20k
+    uint32_t getEstimatedCurrent() const;  // Microamps for the frame as show() will send it
+    uint32_t getPwmSum() const;            // Sum of drawn PWM values (before calibration/scaling)
+    uint32_t getCalibratedPwmSum() const;  // PWM sum with calibration factors applied
+    
     // GFX implementation
     void drawPixel(int16_t x, int16_t y, uint16_t color) override;
     
+    // Full-resolution level for PIXEL_FORMAT_16BIT (PWM = value / 256, master brightness
+    // applied). Other formats keep the high byte.
+    void drawPixel16(int16_t x, int16_t y, uint16_t value);
+    
+    // GFX span fast paths: clip and scale once per span, then fill the buffer directly
+    void writePixel(int16_t x, int16_t y, uint16_t color) override;
+    void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+    void fillScreen(uint16_t color) override;
+    
+    // Copy a pre-rendered 8-bit bitmap into the buffer. stride is the source row
+    // length in bytes (0 = w). modeParam is the key for BLIT_KEYED or the alpha
+    // for BLIT_ALPHA. Master brightness is only applied when scaleBrightness is set.
+    void blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* src, uint16_t stride = 0,
+              BlitMode mode = BLIT_COPY, uint8_t modeParam = 0, bool scaleBrightness = false);
+    
     // Indexed pixel control for custom layouts
     void setPixel(uint16_t index, uint8_t pwm);
     void setLayout(const PixelMapEntry* layout, uint16_t layoutSize);
     
     // Hardware compatibility for IS31FL3737
     void setCoordinateOffset(uint8_t csOffset, uint8_t swOffset);
+    
+    // Select buffer storage format. Owned buffers are re-created (and cleared);
+    // returns false while a caller-owned buffer is attached, or if the new buffer
+    // cannot be had, keeping the old format and buffer.
+    bool setPixelFormat(PixelFormat format);
+    // Replace the expansion palette (16 entries for 4-bit, 2 for 1-bit); nullptr restores the default
+    void setPalette(const uint8_t* palette);
+    
+    // Use caller-owned memory as the PWM buffer instead of allocating in begin().
+    // stride is the row pitch in bytes (0 = packed row size), so the buffer may be a window
+    // into a larger framebuffer. Pass nullptr to detach. Contents are not cleared.
+    bool attachBuffer(uint8_t* buffer, size_t size, uint16_t stride = 0);
+    
+    // Route all register traffic through a transport instead of Adafruit_I2CDevice.
+    // Set before begin(); nullptr restores the default path.
+    void setTransport(IS31FL373x_Transport* transport) { _transport = transport; _currentPage = IS31FL373X_PAGE_UNKNOWN; }
+    IS31FL373x_Transport* getTransport() const { return _transport; }
+    
+    // Place the device behind a multiplexer channel (nullptr = directly on the bus).
+    // The channel is selected automatically before every register access.
+    void setMuxChannel(IS31FL373x_Mux* mux, uint8_t channel) { _mux = mux; _muxChannel = channel; }
+    IS31FL373x_Mux* getMux() const { return _mux; }
+    uint8_t getMuxChannel() const { return _muxChannel; }
+    
+    // Dirty tracking: show() sends nothing while no pixel changed since the last
+    // successful flush. Caller-attached buffers can be written behind the driver's
+    // back, so they always count as dirty.
+    bool isDirty() const {
+        if (_asleep) return getNonZeroPixelCount() != 0;  // Lit content wakes the chip
+        return _dirtyRows != 0 || isBufferAttached();
+    }
+    void markDirty() { markRows(0, IS31FL373X_MAX_ROWS); }  // Force a full resend on the next show()
+    
+    // Flush at most maxBytes of wire traffic (addresses, prefixes and page select
+    // included), longest-stale rows first. Returns true once nothing is left to send.
+    // A budget below one row plus the page select sends nothing. Health probes and
+    // auto-sleep writes run from show() only; failed writes are not retried here.
+    bool showIncremental(uint16_t maxBytes);
+    
+    // Skip page selects when the page is already active (saves 4 bytes per repeat).
+    // Off by default so every show() re-asserts the PWM page in case the chip was
+    // reset or another master changed it.
+    void setPageCaching(bool enable) { _pageCaching = enable; _currentPage = IS31FL373X_PAGE_UNKNOWN; }
+    
+    // Warm start: begin() first reads back the Function page and, if the chip still
+    // holds the configuration this driver would write (e.g. after an MCU-only reboot),
+    // adopts it without the soft reset, its 10 ms delay and the blank frame. The PWM
+    // registers keep showing the old frame until the next show(). Off by default.
+    void setWarmStart(bool enable) { _warmStart = enable; }
+    bool isWarmStarted() const { return _warmStarted; }  // Last begin() skipped the reset
+    
+    // Register write batching: between begin and commit, single-register writes
+    // (setGlobalCurrent(), configuration, LED enables) are queued instead of sent.
+    // Commit sorts them by page and register, sends contiguous runs as auto-increment
+    // bursts and selects each page once. A later write to a queued register replaces
+    // the earlier value. Batches nest; reads, frame flushes and another device opening
+    // a batch commit early. Returns false if any write failed, including writes sent
+    // by an early commit since the batch was opened.
+    void beginRegisterBatch();
+    bool commitRegisterBatch();
+    
+    // Bus errors: failed transactions are counted per device, and each failed write
+    // (register, page select or bulk chunk) is retried up to `retries` times before
+    // the frame is given up and left dirty. Writes queued by a batching transport
+    // fail at endBatch() and are not retried. Default 0.
+    void setRetryLimit(uint8_t retries) { _retryLimit = retries; }
+    uint32_t getErrorCount() const { return _errorCount; }   // Failed attempts, retries included
+    uint32_t getRetryCount() const { return _retryCount; }
+    
+    // Adaptive bus clock between minHz and maxHz (see IS31FL373X_CLOCK_WINDOW). Starts
+    // at maxHz; applied through Adafruit_I2CDevice::setSpeed() or the transport's
+    // setClock(). Devices sharing a bus should be managed by the canvas instead.
+    // maxHz = 0 disables (default).
+    void setBusClockRange(uint32_t minHz, uint32_t maxHz);
+    uint32_t getBusClock() const { return _clockPolicy.clockHz; }  // 0 while disabled
+    
+    // Reset detection: the configuration and GCC registers are read back (two 1-byte
+    // reads) and compared with what the driver last wrote. A chip found at power-on
+    // defaults, e.g. after a supply glitch, gets its LED enables, configuration and
+    // full frame resent; other chips are untouched. checkHealth() returns false when
+    // the chip could not be read or had to be resynced. With an interval set, show()
+    // probes every N calls before flushing. 0 disables (default).
+    bool checkHealth();
+    void setHealthCheckInterval(uint16_t frames) { _healthInterval = frames; _framesSinceProbe = 0; }
+    uint16_t getResyncCount() const { return _resyncs; }
+    
+    // Software shutdown (SSD) for idle chips: once the buffer has been all zeros for
+    // `frames` consecutive show() calls and the dark frame is on the chip, the chip is
+    // shut down and later flushes are skipped. The first show() after a non-zero pixel
+    // is drawn sends the frame, then restores normal operation. 0 disables (default).
+    // Attached buffers always count as dirty and never sleep.
+    void setAutoSleep(uint8_t frames);
+    uint8_t getAutoSleep() const { return _autoSleepFrames; }
+    bool isAsleep() const { return _asleep; }
+    
+#ifdef IS31FL373X_ENABLE_STATS
+    const IS31FL373x_Stats& getStats() const { return _stats; }
+    void resetStats() { _stats.reset(); }
+#endif
 
 protected:
     // Convert hardware CS/SW (1-based) to register index. Derived classes can
     // override to apply chip-specific quirks. Offsets are NOT applied here.
     virtual uint16_t csSwToIndex(uint8_t cs1Based, uint8_t sw1Based) const;
 
+#ifdef IS31FL373X_STATIC_ALLOCATION
+    // Chip classes return their embedded, chip-sized PWM storage
+    virtual uint8_t* getEmbeddedBuffer() { return nullptr; }
+    virtual uint16_t getEmbeddedBufferSize() const { return 0; }
+    alignas(Adafruit_I2CDevice) uint8_t _i2cStorage[sizeof(Adafruit_I2CDevice)];
+#endif
+
     Adafruit_I2CDevice* _i2c_dev;
     uint8_t* _pwmBuffer;
+    uint16_t _bufferStride;  // Row pitch of _pwmBuffer in bytes (>= packed row size)
+    bool _ownsBuffer;        // False when the buffer was supplied via attachBuffer()
+    PixelFormat _pixelFormat;
+    uint8_t _palette[16];    // Packed value -> PWM expansion used at flush time
+    uint8_t _regColumn[16];  // Native format: logical x -> register column (0xFF = unmapped)
     uint8_t _globalCurrent;
     uint8_t _masterBrightness;
     bool _ownsI2CDevice = true;
+    IS31FL373x_Transport* _transport = nullptr;
+    IS31FL373x_Mux* _mux = nullptr;
+    uint8_t _muxChannel = 0;
+    uint8_t _currentPage = IS31FL373X_PAGE_UNKNOWN;  // Last page selected, so repeats can be skipped
+    bool _pageCaching = false;
+    uint16_t _dirtyRows = IS31FL373X_ALL_ROWS;  // Bit y set when logical row y changed since the last flush
+    uint16_t _dirtySince[IS31FL373X_MAX_ROWS] = {};  // _dirtyClock value when each row became dirty
+    uint16_t _pendingRows = 0;                  // Rows chosen for the next incremental flush
+    bool _budgeted = false;                     // Flushing planned rows: no retries, stop at a failure
+    bool _budgetFailed = false;                 // A budgeted write failed; the rest of the frame is skipped
+    uint16_t _ditherRows = 0;                   // Rows holding fractional levels in the last flush
+    uint8_t _ditherPhase = 0;                   // Temporal dither frame counter
+    uint8_t _autoSleepFrames = 0;               // Dark frames before software shutdown (0 = never)
+    uint8_t _darkFrames = 0;                    // Consecutive dark show() calls, saturating
+    bool _asleep = false;                       // SSD cleared: chip shut down, flushes skipped
+    bool _waking = false;                       // Lit frame pending; set SSD after it is sent
+    bool _warmStart = false;
+    bool _warmStarted = false;
+    uint16_t _healthInterval = 0;               // show() calls between reset probes (0 = never)
+    uint16_t _framesSinceProbe = 0;
+    uint16_t _resyncs = 0;                      // Resets detected and recovered
+    uint8_t _retryLimit = 0;
+    uint32_t _errorCount = 0;
+    uint32_t _retryCount = 0;
+    IS31FL373x_ClockPolicy _clockPolicy;
+    uint8_t _outputBrightness = 255;            // Requested overall brightness
+    uint8_t _appliedCurrent = 0;                // GCC register value chosen for it
+    uint16_t _outputScale = 256;                // 8.8 PWM stretch applied at flush time
+    uint16_t _limitScale = 256;                 // 8.8 factor set by a canvas current limiter
+    uint16_t _flushScale = 256;                 // _outputScale x _limitScale, applied in show()
+    uint32_t _isetOhms = 20000;
+    mutable uint32_t _pwmSum = 0;               // Maintained by the write paths while valid
+    mutable uint16_t _nonZeroCount = 0;
+#ifdef IS31FL373X_ENABLE_HISTOGRAM
+    mutable uint16_t _histogram[16] = {};       // LEDs per brightness band (value >> 4)
+#endif
+    mutable bool _pixelStatsValid = false;      // False until the next full rescan
+    const uint8_t* _calibration = nullptr;      // Caller-owned per-LED factors (255 = unity)
+    uint16_t _calibrationStride = 0;
+    static uint16_t _dirtyClock;                // Shared by all devices so canvases can compare staleness
+    uint8_t _batchPage = IS31FL373X_PAGE_UNKNOWN;  // Page selected for queued writes
+    bool _batchFailed = false;                  // A queued write failed; reported by the next commit
+    
+    struct QueuedWrite {
+        uint8_t page;
+        uint8_t reg;
+        uint8_t value;
+    };
+    static IS31FL373x_Device* _batchOwner;      // Device whose writes are being queued
+    static uint8_t _batchDepth;
+    static uint8_t _queueLength;
+    static QueuedWrite _queue[IS31FL373X_WRITE_QUEUE_SIZE];
+#ifdef IS31FL373X_ENABLE_STATS
+    IS31FL373x_Stats _stats;
+#endif
     
     // I2C parameters (stored for delayed initialization)
     uint8_t _addr;
@@ -199,11 +624,76 @@ protected:
     uint8_t _csOffset;
     uint8_t _swOffset;
     
+    // Send the buffer to the PWM page; show() wraps this with timing when stats are on.
+    // Returns false if any bus write failed (the frame stays dirty).
+    virtual bool flushBuffer();
+    bool flushRows(uint16_t rows);   // Send only the given logical rows
+    void flushFrame(uint16_t rows);  // Batch/trace/stats wrapper; ALL_ROWS does a full flush
+    void markRows(uint8_t firstRow, uint8_t endRow);
+    void flushIfDirty();             // show() minus the sleep policy
+    
+    // Auto-sleep policy, run around each show() (the canvas calls these per device).
+    // showIncremental() only counts dark frames; the writes wait for show().
+    void trackDarkFrames();          // Before flushing: count dark frames, or leave sleep
+    void updateSleep();              // After flushing: shut down or finish waking
+    bool writeConfiguration(bool normalOperation);
+    bool verifyConfiguration();      // Function page already holds what begin() writes
+    bool readConfiguration(uint8_t* config, uint8_t* current);
+    bool matchesConfiguration(uint8_t config, uint8_t current) const;
+    bool restoreConfiguration();     // LED enables, SSD and GCC as begin() writes them
+    void pollHealth();               // Probe when the health check interval has elapsed
+    void applyBusClock(uint32_t hz);
+    void recordBatchError();         // A queued frame failed when its batch was closed
+    void forgetBusState();           // Page and mux selects in a lost batch never took effect
+    
+    // Incremental flush planning
+    void beginIncremental();
+    uint16_t getRowFlushCost() const;
+    uint8_t getFlushOverhead() const;
+    void flushPending();             // Send the planned rows within their byte budget
+    static bool pickStaleRow(IS31FL373x_Device* const* devices, uint8_t count, uint16_t& budget);
+    friend class IS31FL373x_Canvas;
+    
+    // Buffer helpers shared by the pixel and span paths
+    void packRegisterRows(uint8_t firstRow, uint8_t rowCount, uint8_t* out);
+    uint8_t flushValue(uint8_t x, uint8_t y);  // PWM value to send, dithered for 16-bit
+    bool hasOutputTransform() const { return _flushScale != 256 || _calibration != nullptr; }
+    uint16_t outputGain(uint8_t x, uint8_t y) const;  // 8.8 calibration x range stretch
+    static uint8_t scaleOutput(uint8_t value, uint16_t gain);
+    void updateCurrentSplit();
+    void setFlushScales(uint16_t outputScale, uint16_t limitScale);
+    uint32_t estimateCurrent(uint16_t scale) const;
+
+    // Pixel statistics kept current by the write paths
+    bool tracksPixelStats() const { return _pixelStatsValid && !isBufferAttached(); }
+    void refreshPixelStats() const;
+    void accountPixel(uint8_t oldValue, uint8_t newValue) const;
+    void accountPixel16(uint16_t oldValue, uint16_t newValue) const;
+    void accountSpan(uint8_t x, uint8_t y, uint16_t count, bool add) const;
+    void storePixel16(uint8_t x, uint8_t y, uint16_t value);
+    uint8_t scaleColor(uint16_t color) const;
+    void fillBufferRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t value);
+    bool fillPackedSpan(uint8_t x, uint8_t y, uint16_t count, uint8_t value);  // True if any byte changed
+    bool fillNativeSpan(uint8_t x, uint8_t y, uint16_t count, uint8_t value);
+    uint16_t nativeOffset(uint8_t x, uint8_t y) const;
+    void rebuildRegisterMap();
+    uint8_t loadPixel(uint8_t x, uint8_t y) const;
+    void storePixel(uint8_t x, uint8_t y, uint8_t value);
+    static uint8_t quantize4(uint8_t value);
+    void setDefaultPalette();
+    bool allocateBuffer();
+    void releaseBuffer();
+    
     // Low-level I2C operations
     bool selectPage(uint8_t page);
     bool writeRegister(uint8_t reg, uint8_t value);
     bool writeBulk(uint8_t startReg, const uint8_t* data, size_t length);
     bool readRegister(uint8_t reg, uint8_t* value);
+    bool busWrite(const uint8_t* prefix, size_t prefixLen, const uint8_t* data, size_t length);
+    bool isBatching() const { return _batchOwner == this; }
+    bool queueWrite(uint8_t reg, uint8_t value);
+    bool sendQueue();                // Send queued writes, leaving _batchPage selected
+    bool closeBatch();               // Send and end the batch regardless of nesting
     virtual bool isValidCsPin(uint8_t cs1Based) const;
     bool isValidCsSw(uint8_t cs1Based, uint8_t sw1Based) const;
     
@@ -214,17 +704,29 @@ public:
     
     // State inspection methods for testing
     uint8_t getGlobalCurrent() const { return _globalCurrent; }
+    uint8_t getAppliedCurrent() const { return _appliedCurrent; }  // GCC register value in use
+    uint16_t getOutputScale() const { return _outputScale; }
     uint8_t getMasterBrightness() const { return _masterBrightness; }
     uint8_t getPixelValue(uint16_t x, uint16_t y) const;
+    uint16_t getPixelValue16(uint16_t x, uint16_t y) const;  // 8.8 level (8-bit formats: value << 8)
     uint8_t getPixelValueByIndex(uint16_t index) const;
-    uint16_t getNonZeroPixelCount() const;
+    uint16_t getNonZeroPixelCount() const;  // O(1): maintained as pixels change
     uint16_t getPixelSum() const;
+#ifdef IS31FL373X_ENABLE_HISTOGRAM
+    uint16_t getHistogramBin(uint8_t bin) const;  // LEDs with value >> 4 == bin (16 bins)
+#endif
     bool isCustomLayoutActive() const { return _useCustomLayout; }
+    bool isBufferAttached() const { return _pwmBuffer != nullptr && !_ownsBuffer; }
+    uint16_t getBufferStride() const { return _bufferStride; }
+    PixelFormat getPixelFormat() const { return _pixelFormat; }
+    uint8_t getBitsPerPixel() const;
+    uint16_t getRowBytes() const;
+    uint16_t getBufferBytes() const;  // Storage needed for the current format
     uint16_t getLayoutSize() const { return _layoutSize; }
     uint8_t getI2CAddress() const { return _addr; }
 #ifdef UNIT_TEST
     // Test-only: inject a custom I2C device without transferring ownership
-    void setI2CDeviceForTest(Adafruit_I2CDevice* dev) { _i2c_dev = dev; _ownsI2CDevice = false; }
+    void setI2CDeviceForTest(Adafruit_I2CDevice* dev) { _i2c_dev = dev; _ownsI2CDevice = false; _currentPage = IS31FL373X_PAGE_UNKNOWN; }
 #endif
 };
 
@@ -246,6 +748,11 @@ public:
 
 private:
     uint8_t calculateAddress(ADDR addr1, ADDR addr2);
+#ifdef IS31FL373X_STATIC_ALLOCATION
+    uint8_t _embeddedBuffer[PWM_BUFFER_SIZE];
+    uint8_t* getEmbeddedBuffer() override { return _embeddedBuffer; }
+    uint16_t getEmbeddedBufferSize() const override { return sizeof(_embeddedBuffer); }
+#endif
 };
 
 /**
@@ -272,6 +779,11 @@ protected:
 
 private:
     uint8_t calculateAddress(ADDR addr);
+#ifdef IS31FL373X_STATIC_ALLOCATION
+    uint8_t _embeddedBuffer[PWM_BUFFER_SIZE];
+    uint8_t* getEmbeddedBuffer() override { return _embeddedBuffer; }
+    uint16_t getEmbeddedBufferSize() const override { return sizeof(_embeddedBuffer); }
+#endif
 };
 
 /**
@@ -296,6 +808,11 @@ public:
 
 private:
     uint8_t calculateAddress(ADDR addr);
+#ifdef IS31FL373X_STATIC_ALLOCATION
+    uint8_t _embeddedBuffer[PWM_BUFFER_SIZE];
+    uint8_t* getEmbeddedBuffer() override { return _embeddedBuffer; }
+    uint16_t getEmbeddedBufferSize() const override { return sizeof(_embeddedBuffer); }
+#endif
 };
 
 /**
@@ -312,14 +829,27 @@ public:
     // Canvas control
     bool begin();
     void show();
+    bool showIncremental(uint16_t maxBytes);  // Budget shared by all devices, stalest rows first
     void clear();
     
     // Brightness control for all devices
     void setGlobalCurrent(uint8_t current);
     void setMasterBrightness(uint8_t brightness);
+    void setOutputBrightness(uint8_t brightness);  // GCC/PWM range split on every device
+    bool setCalibration(const uint8_t* factors);   // Canvas-sized table (row pitch = canvas width)
+    
+    // Back every device with one caller-owned width*height framebuffer (row pitch =
+    // canvas width). Each device views its own window, so writing the whole
+    // framebuffer updates all devices with no per-device copy.
+    bool attachBuffer(uint8_t* buffer, size_t size);
     
     // GFX implementation
     void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    void drawPixel16(int16_t x, int16_t y, uint16_t value);
+    
+    // Copy a pre-rendered 8-bit bitmap across device boundaries (see IS31FL373x_Device::blit)
+    void blit(int16_t x, int16_t y, int16_t w, int16_t h, const uint8_t* src, uint16_t stride = 0,
+              BlitMode mode = BLIT_COPY, uint8_t modeParam = 0, bool scaleBrightness = false);
     
     // Device identification helper
     void identifyDevices();
@@ -330,15 +860,63 @@ public:
         return (index < _deviceCount) ? _devices[index] : nullptr; 
     }
     CanvasLayout getLayout() const { return _layout; }
-    uint16_t getTotalNonZeroPixelCount() const;
+    uint32_t getTotalNonZeroPixelCount() const;
+    uint32_t getTotalPixelSum() const;
+    
+    // Current limiter: before each flush the devices' estimated current is summed and,
+    // above the budget, every device is dimmed by the same factor at flush time.
+    void setCurrentBudget(uint32_t microamps);  // 0 = unlimited
+    uint32_t getCurrentBudget() const { return _currentBudget; }
+    uint32_t getEstimatedCurrent() const;       // Sum over devices, limiting included
+    uint16_t getLimitScale() const { return _limitScale; }  // 8.8, 256 = not limiting
+    
+    // Retry and adaptive clock for all devices. The canvas runs one clock policy on the
+    // errors of every device, so chips sharing a bus do not fight over its speed.
+    void setRetryLimit(uint8_t retries);
+    void setBusClockRange(uint32_t minHz, uint32_t maxHz);
+    uint32_t getBusClock() const { return _clockPolicy.clockHz; }
+    uint32_t getErrorCount() const;   // Failed attempts, all devices
+    
+    // Probe each device for resets every N frames (see IS31FL373x_Device::checkHealth)
+    void setHealthCheckInterval(uint16_t frames);
+    uint32_t getResyncCount() const;  // Resets recovered, all devices
+    
+    // Adopt chips that kept their configuration (see IS31FL373x_Device::setWarmStart)
+    void setWarmStart(bool enable);
+    
+    // Shut down devices whose region stays dark (see IS31FL373x_Device::setAutoSleep)
+    void setAutoSleep(uint8_t frames);
+    
+    bool isDirty() const;    // Any device would send data on show()
+    void markDirty();        // Force every device to resend on the next show()
+    
+#ifdef IS31FL373X_ENABLE_STATS
+    // Bus counters summed over all devices; frames and flush latency are per canvas show()
+    IS31FL373x_Stats getStats() const;
+    void resetStats();
+#endif
 
 private:
     IS31FL373x_Device** _devices;
     uint8_t _deviceCount;
     CanvasLayout _layout;
+    uint32_t _currentBudget = 0;
+    uint16_t _limitScale = 256;
+    IS31FL373x_ClockPolicy _clockPolicy;
+#ifdef IS31FL373X_ENABLE_STATS
+    IS31FL373x_Stats _stats;  // Canvas-level frames and flush latency
+#endif
     
     // Helper methods
+    bool sharesMuxPath(uint8_t a, uint8_t b) const;
+    void flushGroups(bool incremental);  // Flush devices grouped by mux path
+    void applyCurrentLimit();
+    void prepareDevices(bool probe);  // Dark-frame counting, plus health probes if probe
+    void updateSleep();
+    void updateBusClock();
+    void applyBusClock();   // Current policy clock to every device
     IS31FL373x_Device* getDeviceForCoordinate(int16_t x, int16_t y, int16_t* localX, int16_t* localY);
+    void getDeviceOrigin(uint8_t index, int16_t* originX, int16_t* originY) const;
 };
 
 #endif // IS31FL373X_H
@@ -0,0 +1,60 @@
+#include "IS31FL373x_Capture.h"
+
+IS31FL373x_CaptureTransport::IS31FL373x_CaptureTransport(IS31FL373x_Transport* inner, Writer writer,
+                                                         void* context)
+    : _inner(inner), _writer(writer), _context(context), _batchDepth(0), _records(0) {
+}
+
+void IS31FL373x_CaptureTransport::start() {
+    if (_writer == nullptr) return;
+    uint8_t header[IS31FL373X_CAPTURE_HEADER_SIZE] = {'I', '3', '7', 'C', 'A', 'P', 0x00,
+                                                      IS31FL373X_CAPTURE_VERSION};
+    _writer(header, sizeof(header), _context);
+}
+
+bool IS31FL373x_CaptureTransport::write(uint8_t addr, const uint8_t* prefix, size_t prefixLen,
+                                        const uint8_t* data, size_t length) {
+    bool ok = (_inner != nullptr) && _inner->write(addr, prefix, prefixLen, data, length);
+    uint8_t type = IS31FL373X_CAPTURE_WRITE | (ok ? 0 : IS31FL373X_CAPTURE_FAILED);
+    record(type, addr, prefix, prefix ? prefixLen : 0, data, data ? length : 0);
+    return ok;
+}
+
+bool IS31FL373x_CaptureTransport::read(uint8_t addr, uint8_t reg, uint8_t* data, size_t length) {
+    bool ok = (_inner != nullptr) && _inner->read(addr, reg, data, length);
+    uint8_t type = IS31FL373X_CAPTURE_READ | (ok ? 0 : IS31FL373X_CAPTURE_FAILED);
+    record(type, addr, &reg, 1, data, data ? length : 0);
+    return ok;
+}
+
+void IS31FL373x_CaptureTransport::beginBatch() {
+    _batchDepth++;
+    if (_inner != nullptr) _inner->beginBatch();
+}
+
+bool IS31FL373x_CaptureTransport::endBatch() {
+    bool ok = (_inner == nullptr) || _inner->endBatch();
+    if (_batchDepth > 0 && --_batchDepth == 0) {
+        record(IS31FL373X_CAPTURE_FRAME, 0, nullptr, 0, nullptr, 0);
+    }
+    return ok;
+}
+
+void IS31FL373x_CaptureTransport::record(uint8_t type, uint8_t addr, const uint8_t* first, size_t firstLen,
+                                         const uint8_t* second, size_t secondLen) {
+    if (_writer == nullptr) return;
+    uint32_t now = static_cast<uint32_t>(micros());
+    uint16_t length = static_cast<uint16_t>(firstLen + secondLen);
+    uint8_t header[IS31FL373X_CAPTURE_RECORD_SIZE] = {
+        type,
+        static_cast<uint8_t>(now), static_cast<uint8_t>(now >> 8),
+        static_cast<uint8_t>(now >> 16), static_cast<uint8_t>(now >> 24),
+        addr,
+        static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8)
+    };
+    // Header and payload pieces are streamed as-is; nothing is buffered here
+    _writer(header, sizeof(header), _context);
+    if (firstLen > 0) _writer(first, firstLen, _context);
+    if (secondLen > 0) _writer(second, secondLen, _context);
+    _records++;
+}
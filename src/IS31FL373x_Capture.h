@@ -0,0 +1,42 @@
+#ifndef IS31FL373X_CAPTURE_H
+#define IS31FL373X_CAPTURE_H
+
+#include "IS31FL373x.h"
+#include "IS31FL373x_CaptureFormat.h"
+
+/**
+ * Transport decorator that records bus traffic in the binary capture format
+ * Wrap any transport (IS31FL373x_WireTransport for the default Wire path). Bytes
+ * are streamed to a caller-supplied writer (file, Serial, SD card) as they happen;
+ * a FRAME record follows each outermost batch, i.e. each device or canvas show().
+ */
+class IS31FL373x_CaptureTransport : public IS31FL373x_Transport {
+public:
+    typedef void (*Writer)(const uint8_t* data, size_t length, void* context);
+
+    IS31FL373x_CaptureTransport(IS31FL373x_Transport* inner, Writer writer, void* context = nullptr);
+
+    void start();   // Emit the file header; call once before the first transaction
+
+    bool write(uint8_t addr, const uint8_t* prefix, size_t prefixLen,
+               const uint8_t* data, size_t length) override;
+    bool read(uint8_t addr, uint8_t reg, uint8_t* data, size_t length) override;
+    void beginBatch() override;
+    bool endBatch() override;
+    bool setClock(uint32_t hz) override { return (_inner != nullptr) && _inner->setClock(hz); }
+
+    // State inspection methods for testing
+    uint32_t getRecordCount() const { return _records; }
+
+private:
+    IS31FL373x_Transport* _inner;
+    Writer _writer;
+    void* _context;
+    uint8_t _batchDepth;
+    uint32_t _records;
+
+    void record(uint8_t type, uint8_t addr, const uint8_t* first, size_t firstLen,
+                const uint8_t* second, size_t secondLen);
+};
+
+#endif // IS31FL373X_CAPTURE_H
@@ -0,0 +1,162 @@
+#include "IS31FL373x_CaptureAnalyzer.h"
+
+#if !defined(ARDUINO)
+#include <string.h>
+
+// Chip registers involved in page handling (see IS31FL373x.h)
+static const uint8_t REG_UNLOCK = 0xFE;
+static const uint8_t REG_COMMAND = 0xFD;
+static const uint8_t PAGE_FUNCTION = 0x03;
+static const uint8_t REG_RESET = 0x11;  // Reading it resets the chip
+
+IS31FL373x_CaptureAnalyzer::IS31FL373x_CaptureAnalyzer()
+    : _headerSeen(false), _valid(true), _frames(0), _totalBytes(0) {
+}
+
+bool IS31FL373x_CaptureAnalyzer::feed(const uint8_t* data, size_t length) {
+    if (!_valid) return false;
+    _pending.insert(_pending.end(), data, data + length);
+    size_t consumed = parse(_pending.data(), _pending.size());
+    _pending.erase(_pending.begin(), _pending.begin() + consumed);
+    return _valid;
+}
+
+size_t IS31FL373x_CaptureAnalyzer::parse(const uint8_t* data, size_t length) {
+    size_t offset = 0;
+    if (!_headerSeen) {
+        if (length < IS31FL373X_CAPTURE_HEADER_SIZE) return 0;
+        if (memcmp(data, IS31FL373X_CAPTURE_MAGIC, 6) != 0 || data[6] != 0x00 ||
+            data[7] != IS31FL373X_CAPTURE_VERSION) {
+            _valid = false;
+            return length;
+        }
+        _headerSeen = true;
+        offset = IS31FL373X_CAPTURE_HEADER_SIZE;
+    }
+
+    while (length - offset >= IS31FL373X_CAPTURE_RECORD_SIZE) {
+        const uint8_t* header = &data[offset];
+        uint16_t payloadLength = static_cast<uint16_t>(header[6] | (header[7] << 8));
+        size_t recordLength = IS31FL373X_CAPTURE_RECORD_SIZE + static_cast<size_t>(payloadLength);
+        if (length - offset < recordLength) break;  // Wait for more
+        const uint8_t* payload = header + IS31FL373X_CAPTURE_RECORD_SIZE;
+        uint8_t type = header[0] & ~IS31FL373X_CAPTURE_FAILED;
+        bool failed = (header[0] & IS31FL373X_CAPTURE_FAILED) != 0;
+
+        if (type == IS31FL373X_CAPTURE_FRAME) {
+            _frames++;
+        } else if (type == IS31FL373X_CAPTURE_WRITE || type == IS31FL373X_CAPTURE_READ) {
+            ChipState& state = chip(header[5]);
+            uint32_t wireBytes = payloadLength + ((type == IS31FL373X_CAPTURE_READ) ? 2 : 1);
+            state.report.bytes += wireBytes;
+            state.report.transactions++;
+            _totalBytes += wireBytes;
+            if (failed) {
+                state.page = -1;  // The chip may or may not have seen it
+            } else if (type == IS31FL373X_CAPTURE_WRITE) {
+                applyWrite(state, payload, payloadLength);
+            } else {
+                applyRead(state, payload, payloadLength);
+            }
+        } else {
+            _valid = false;
+            return length;
+        }
+        offset += recordLength;
+    }
+    return offset;
+}
+
+IS31FL373x_CaptureAnalyzer::ChipState& IS31FL373x_CaptureAnalyzer::chip(uint8_t addr) {
+    for (size_t i = 0; i < _chips.size(); i++) {
+        if (_chips[i].report.addr == addr) return _chips[i];
+    }
+    ChipState state;
+    memset(&state, 0, sizeof(state));
+    state.report.addr = addr;
+    state.page = -1;
+    _chips.push_back(state);
+    return _chips.back();
+}
+
+void IS31FL373x_CaptureAnalyzer::applyWrite(ChipState& state, const uint8_t* payload, uint16_t length) {
+    if (length == 0) return;
+    uint8_t reg = payload[0];
+    uint8_t unlockBytes = state.lastUnlockBytes;
+    state.lastUnlockBytes = 0;
+
+    if (reg == REG_UNLOCK) {
+        state.lastUnlockBytes = static_cast<uint8_t>(length + 1);
+        return;
+    }
+    if (reg == REG_COMMAND) {
+        if (length < 2) return;
+        if (state.page == payload[1]) {
+            state.report.redundantPageSelects++;
+            state.report.redundantSelectBytes += unlockBytes + length + 1;
+        }
+        state.page = (payload[1] < 4) ? payload[1] : -1;
+        return;
+    }
+    if (state.page < 0) return;  // Data landing on an unknown page cannot be judged
+
+    // Register auto-increment: payload[1..] fills reg, reg+1, ...
+    for (uint16_t i = 1; i < length && reg + i - 1 <= 0xFF; i++) {
+        uint8_t target = static_cast<uint8_t>(reg + i - 1);
+        if (state.known[state.page][target] && state.regs[state.page][target] == payload[i]) {
+            state.report.redundantBytes++;
+        }
+        state.regs[state.page][target] = payload[i];
+        state.known[state.page][target] = true;
+    }
+}
+
+void IS31FL373x_CaptureAnalyzer::applyRead(ChipState& state, const uint8_t* payload, uint16_t length) {
+    state.lastUnlockBytes = 0;
+    if (length == 0) return;
+    if (state.page == PAGE_FUNCTION && payload[0] == REG_RESET) {
+        // Software reset: registers return to defaults the capture never showed
+        memset(state.known, 0, sizeof(state.known));
+        state.page = -1;
+    }
+}
+
+uint32_t IS31FL373x_CaptureAnalyzer::getRedundantBytes() const {
+    uint32_t total = 0;
+    for (size_t i = 0; i < _chips.size(); i++) total += _chips[i].report.redundantBytes;
+    return total;
+}
+
+uint32_t IS31FL373x_CaptureAnalyzer::getRedundantPageSelects() const {
+    uint32_t total = 0;
+    for (size_t i = 0; i < _chips.size(); i++) total += _chips[i].report.redundantPageSelects;
+    return total;
+}
+
+uint32_t IS31FL373x_CaptureAnalyzer::getRedundantSelectBytes() const {
+    uint32_t total = 0;
+    for (size_t i = 0; i < _chips.size(); i++) total += _chips[i].report.redundantSelectBytes;
+    return total;
+}
+
+void IS31FL373x_CaptureAnalyzer::printReport(FILE* out) const {
+    double total = (_totalBytes > 0) ? static_cast<double>(_totalBytes) : 1.0;
+    fprintf(out, "frames:                  %lu\n", static_cast<unsigned long>(_frames));
+    fprintf(out, "bytes:                   %lu (%.1f per frame)\n",
+            static_cast<unsigned long>(_totalBytes), getBytesPerFrame());
+    fprintf(out, "redundant data bytes:    %lu (%.1f%%)\n",
+            static_cast<unsigned long>(getRedundantBytes()), 100.0 * getRedundantBytes() / total);
+    fprintf(out, "redundant page selects:  %lu (%lu bytes, %.1f%%)\n",
+            static_cast<unsigned long>(getRedundantPageSelects()),
+            static_cast<unsigned long>(getRedundantSelectBytes()), 100.0 * getRedundantSelectBytes() / total);
+    fprintf(out, "\n addr   bytes     share   transactions  redundant\n");
+    for (size_t i = 0; i < _chips.size(); i++) {
+        const ChipReport& chip = _chips[i].report;
+        fprintf(out, " 0x%02X %8lu  %6.1f%%  %12lu  %9lu\n", chip.addr,
+                static_cast<unsigned long>(chip.bytes), 100.0 * chip.bytes / total,
+                static_cast<unsigned long>(chip.transactions),
+                static_cast<unsigned long>(chip.redundantBytes + chip.redundantSelectBytes));
+    }
+}
+
+#endif // !ARDUINO
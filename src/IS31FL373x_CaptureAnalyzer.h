@@ -0,0 +1,69 @@
+#ifndef IS31FL373X_CAPTUREANALYZER_H
+#define IS31FL373X_CAPTUREANALYZER_H
+
+#include "IS31FL373x_CaptureFormat.h"
+
+#if !defined(ARDUINO)
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+/**
+ * Offline analyzer for binary I2C captures (native builds only)
+ * Replays the capture against a model of each chip's page and register state to
+ * find bytes that changed nothing. Byte counts include the I2C address byte of
+ * every transaction (two for reads: register write + read).
+ */
+class IS31FL373x_CaptureAnalyzer {
+public:
+    struct ChipReport {
+        uint8_t addr;
+        uint32_t bytes;                 // Wire bytes to/from this chip
+        uint32_t transactions;
+        uint32_t redundantBytes;        // Data bytes rewriting the value a register already held
+        uint32_t redundantPageSelects;  // Selects of the page that was already active
+        uint32_t redundantSelectBytes;  // Wire bytes spent on those selects (unlock included)
+    };
+
+    IS31FL373x_CaptureAnalyzer();
+
+    // Feed capture bytes in any split; returns false once the stream is malformed
+    bool feed(const uint8_t* data, size_t length);
+    bool isValid() const { return _valid; }
+
+    uint32_t getFrameCount() const { return _frames; }
+    uint32_t getTotalBytes() const { return _totalBytes; }
+    uint32_t getRedundantBytes() const;        // Redundant data bytes, all chips
+    uint32_t getRedundantPageSelects() const;
+    uint32_t getRedundantSelectBytes() const;
+    double getBytesPerFrame() const { return _frames ? static_cast<double>(_totalBytes) / _frames : 0.0; }
+    size_t getChipCount() const { return _chips.size(); }
+    const ChipReport& getChip(size_t index) const { return _chips[index].report; }
+
+    void printReport(FILE* out) const;
+
+private:
+    struct ChipState {
+        ChipReport report;
+        int page;                       // -1 when unknown
+        uint8_t lastUnlockBytes;        // Bytes of a preceding unlock, charged to a redundant select
+        uint8_t regs[4][256];
+        bool known[4][256];
+    };
+
+    std::vector<uint8_t> _pending;      // Partial header/record carried between feed() calls
+    std::vector<ChipState> _chips;
+    bool _headerSeen;
+    bool _valid;
+    uint32_t _frames;
+    uint32_t _totalBytes;
+
+    size_t parse(const uint8_t* data, size_t length);
+    ChipState& chip(uint8_t addr);
+    void applyWrite(ChipState& state, const uint8_t* payload, uint16_t length);
+    void applyRead(ChipState& state, const uint8_t* payload, uint16_t length);
+};
+
+#endif // !ARDUINO
+#endif // IS31FL373X_CAPTUREANALYZER_H
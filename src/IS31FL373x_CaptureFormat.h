@@ -0,0 +1,26 @@
+#ifndef IS31FL373X_CAPTUREFORMAT_H
+#define IS31FL373X_CAPTUREFORMAT_H
+
+/**
+ * Binary I2C capture format (little-endian, no dependencies)
+ *
+ * File header (8 bytes):  'I' '3' '7' 'C' 'A' 'P' 0x00 version
+ * Record header (8 bytes): type, micros (uint32), addr (7-bit), length (uint16)
+ * Record payload (length bytes):
+ *   WRITE  bytes after the I2C address byte (register first, then data)
+ *   READ   register address followed by the bytes read
+ *   FRAME  no payload; marks the end of a flushed frame
+ * Bit 7 of the type byte is set when the transaction failed.
+ */
+
+#define IS31FL373X_CAPTURE_MAGIC          "I37CAP"
+#define IS31FL373X_CAPTURE_VERSION        1
+#define IS31FL373X_CAPTURE_HEADER_SIZE    8
+#define IS31FL373X_CAPTURE_RECORD_SIZE    8
+
+#define IS31FL373X_CAPTURE_WRITE          0x00
+#define IS31FL373X_CAPTURE_READ           0x01
+#define IS31FL373X_CAPTURE_FRAME          0x02
+#define IS31FL373X_CAPTURE_FAILED         0x80
+
+#endif // IS31FL373X_CAPTUREFORMAT_H
@@ -0,0 +1,57 @@
+#include "IS31FL373x_ChromeTrace.h"
+
+#if defined(IS31FL373X_ENABLE_TRACE) && !defined(ARDUINO)
+
+static const char* traceEventName(IS31FL373x_TraceEvent event) {
+    switch (event) {
+        case TRACE_CANVAS_SHOW:    return "canvas.show";
+        case TRACE_SHOW:           return "show";
+        case TRACE_PAGE_SELECT:    return "selectPage";
+        case TRACE_REGISTER_WRITE: return "writeRegister";
+        case TRACE_BULK_CHUNK:     return "writeBulk";
+        default:                   return "unknown";
+    }
+}
+
+IS31FL373x_ChromeTrace::IS31FL373x_ChromeTrace(FILE* out)
+    : _out(out), _events(0), _installed(false) {
+}
+
+IS31FL373x_ChromeTrace::~IS31FL373x_ChromeTrace() {
+    finish();
+}
+
+void IS31FL373x_ChromeTrace::install() {
+    if (_installed || _out == nullptr) return;
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", _out);
+    _events = 0;
+    _installed = true;
+    IS31FL373x_setTraceHook(hook, this);
+}
+
+void IS31FL373x_ChromeTrace::finish() {
+    if (!_installed) return;
+    IS31FL373x_setTraceHook(nullptr);
+    fputs("\n]}\n", _out);
+    fflush(_out);
+    _installed = false;
+}
+
+void IS31FL373x_ChromeTrace::hook(const IS31FL373x_TraceRecord& record, void* context) {
+    static_cast<IS31FL373x_ChromeTrace*>(context)->write(record);
+}
+
+void IS31FL373x_ChromeTrace::write(const IS31FL373x_TraceRecord& record) {
+    // Duration events: "B" on entry, "E" on exit, one lane (tid) per chip address
+    fprintf(_out, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":1,\"tid\":%u",
+            (_events == 0) ? "" : ",", traceEventName(record.event), record.begin ? 'B' : 'E',
+            static_cast<unsigned long>(record.micros), static_cast<unsigned>(record.addr));
+    if (record.begin && record.event != TRACE_CANVAS_SHOW) {
+        fprintf(_out, ",\"args\":{\"reg\":%u,\"bytes\":%u}", static_cast<unsigned>(record.reg),
+                static_cast<unsigned>(record.length));
+    }
+    fputc('}', _out);
+    _events++;
+}
+
+#endif // IS31FL373X_ENABLE_TRACE && !ARDUINO
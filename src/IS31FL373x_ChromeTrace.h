@@ -0,0 +1,36 @@
+#ifndef IS31FL373X_CHROMETRACE_H
+#define IS31FL373X_CHROMETRACE_H
+
+#include "IS31FL373x.h"
+
+#if defined(IS31FL373X_ENABLE_TRACE) && !defined(ARDUINO)
+#include <stdio.h>
+
+/**
+ * Trace sink writing Chrome trace-event JSON (native builds only)
+ * Load the file in chrome://tracing or ui.perfetto.dev: each chip address is a
+ * thread lane, the canvas frame is lane 0, and timestamps come from micros().
+ */
+class IS31FL373x_ChromeTrace {
+public:
+    explicit IS31FL373x_ChromeTrace(FILE* out);
+    ~IS31FL373x_ChromeTrace();
+
+    void install();   // Become the global trace hook and open the JSON document
+    void finish();    // Remove the hook and close the JSON document
+
+    // State inspection methods for testing
+    uint32_t getEventCount() const { return _events; }
+
+    static void hook(const IS31FL373x_TraceRecord& record, void* context);
+
+private:
+    FILE* _out;
+    uint32_t _events;
+    bool _installed;
+
+    void write(const IS31FL373x_TraceRecord& record);
+};
+
+#endif // IS31FL373X_ENABLE_TRACE && !ARDUINO
+#endif // IS31FL373X_CHROMETRACE_H
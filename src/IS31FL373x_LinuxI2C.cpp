@@ -0,0 +1,135 @@
+#include "IS31FL373x_LinuxI2C.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/i2c-dev.h>
+
+static int systemIoctl(int fd, unsigned long request, void* arg) {
+    return ioctl(fd, request, arg);
+}
+
+IS31FL373x_LinuxI2C::IS31FL373x_LinuxI2C(const char* devicePath)
+    : _devicePath(devicePath), _fd(-1), _ownsFd(false), _ioctl(systemIoctl), _ioctlCount(0),
+      _msgCount(0), _queueUsed(0), _batchDepth(0), _batchOk(true) {
+}
+
+IS31FL373x_LinuxI2C::~IS31FL373x_LinuxI2C() {
+    end();
+}
+
+bool IS31FL373x_LinuxI2C::begin() {
+    if (_fd >= 0) return true;
+    if (_devicePath == nullptr) return false;
+    int fd = open(_devicePath, O_RDWR);
+    if (fd < 0) return false;
+    _fd = fd;
+    _ownsFd = true;
+    return true;
+}
+
+bool IS31FL373x_LinuxI2C::begin(int fd) {
+    if (fd < 0) return false;
+    end();
+    _fd = fd;
+    _ownsFd = false;
+    return true;
+}
+
+void IS31FL373x_LinuxI2C::end() {
+    flush();
+    if (_fd >= 0 && _ownsFd) {
+        close(_fd);
+    }
+    _fd = -1;
+    _ownsFd = false;
+    _batchDepth = 0;
+    _batchOk = true;
+}
+
+void IS31FL373x_LinuxI2C::setIoctl(IoctlFunction fn) {
+    _ioctl = (fn != nullptr) ? fn : systemIoctl;
+}
+
+bool IS31FL373x_LinuxI2C::write(uint8_t addr, const uint8_t* prefix, size_t prefixLen,
+                                const uint8_t* data, size_t length) {
+    if (prefix == nullptr) prefixLen = 0;
+    if (data == nullptr) length = 0;
+    size_t total = prefixLen + length;
+    if (_fd < 0 || total == 0 || total > IS31FL373X_LINUX_I2C_QUEUE_BYTES) return false;
+
+    // Make room; a failed early flush is reported by endBatch()
+    if (_msgCount == IS31FL373X_LINUX_I2C_MAX_MSGS || _queueUsed + total > IS31FL373X_LINUX_I2C_QUEUE_BYTES) {
+        if (!flush()) _batchOk = false;
+    }
+
+    // Callers may pass stack buffers, so the message owns a copy in the queue
+    uint8_t* buf = &_queue[_queueUsed];
+    if (prefixLen > 0) memcpy(buf, prefix, prefixLen);
+    if (length > 0) memcpy(buf + prefixLen, data, length);
+    _queueUsed += total;
+
+    struct i2c_msg& msg = _msgs[_msgCount++];
+    msg.addr = addr;
+    msg.flags = 0;
+    msg.len = static_cast<uint16_t>(total);
+    msg.buf = buf;
+
+    if (_batchDepth > 0) return true;
+    return flush();
+}
+
+bool IS31FL373x_LinuxI2C::read(uint8_t addr, uint8_t reg, uint8_t* data, size_t length) {
+    if (_fd < 0 || data == nullptr || length == 0) return false;
+
+    // Queued writes must reach the chip first (e.g. the page select before this read)
+    if (!flush()) {
+        _batchOk = false;
+        return false;
+    }
+
+    // Register address and read in one combined transfer (repeated start)
+    struct i2c_msg msgs[2];
+    msgs[0].addr = addr;
+    msgs[0].flags = 0;
+    msgs[0].len = 1;
+    msgs[0].buf = &reg;
+    msgs[1].addr = addr;
+    msgs[1].flags = I2C_M_RD;
+    msgs[1].len = static_cast<uint16_t>(length);
+    msgs[1].buf = data;
+    return transfer(msgs, 2);
+}
+
+void IS31FL373x_LinuxI2C::beginBatch() {
+    if (_batchDepth == 0) _batchOk = true;
+    _batchDepth++;
+}
+
+bool IS31FL373x_LinuxI2C::endBatch() {
+    if (_batchDepth == 0) return false;
+    if (--_batchDepth > 0) return true;
+    if (!flush()) _batchOk = false;
+    return _batchOk;
+}
+
+bool IS31FL373x_LinuxI2C::flush() {
+    if (_msgCount == 0) return true;
+    bool ok = transfer(_msgs, _msgCount);
+    _msgCount = 0;
+    _queueUsed = 0;
+    return ok;
+}
+
+bool IS31FL373x_LinuxI2C::transfer(struct i2c_msg* msgs, uint32_t count) {
+    if (_fd < 0) return false;
+    struct i2c_rdwr_ioctl_data request;
+    request.msgs = msgs;
+    request.nmsgs = count;
+    _ioctlCount++;
+    return _ioctl(_fd, I2C_RDWR, &request) >= 0;
+}
+
+#endif // __linux__
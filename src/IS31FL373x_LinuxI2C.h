@@ -0,0 +1,70 @@
+#ifndef IS31FL373X_LINUXI2C_H
+#define IS31FL373X_LINUXI2C_H
+
+#include "IS31FL373x.h"
+
+#if defined(__linux__)
+#include <linux/i2c.h>
+
+// Kernel cap on messages per I2C_RDWR call (I2C_RDWR_IOCTL_MAX_MSGS)
+#ifndef IS31FL373X_LINUX_I2C_MAX_MSGS
+#define IS31FL373X_LINUX_I2C_MAX_MSGS 42
+#endif
+
+// Bytes of queued write data (register prefixes included) held per batch
+#ifndef IS31FL373X_LINUX_I2C_QUEUE_BYTES
+#define IS31FL373X_LINUX_I2C_QUEUE_BYTES 2048
+#endif
+
+/**
+ * Linux i2c-dev transport (/dev/i2c-N)
+ * Writes issued inside a batch are queued as i2c_msg entries and sent with one
+ * I2C_RDWR ioctl, so a canvas flush costs one syscall per bus. The queue is sent
+ * early only when the kernel message limit or the byte queue fills up.
+ */
+class IS31FL373x_LinuxI2C : public IS31FL373x_Transport {
+public:
+    typedef int (*IoctlFunction)(int fd, unsigned long request, void* arg);
+
+    explicit IS31FL373x_LinuxI2C(const char* devicePath = "/dev/i2c-1");
+    ~IS31FL373x_LinuxI2C() override;
+
+    bool begin();        // Open devicePath
+    bool begin(int fd);  // Use an already-open descriptor (left open by end())
+    void end();
+
+    bool write(uint8_t addr, const uint8_t* prefix, size_t prefixLen,
+               const uint8_t* data, size_t length) override;
+    bool read(uint8_t addr, uint8_t reg, uint8_t* data, size_t length) override;
+    void beginBatch() override;
+    bool endBatch() override;
+
+    // Route ioctl() calls elsewhere, e.g. to a fake bus in tests; nullptr restores ::ioctl
+    void setIoctl(IoctlFunction fn);
+
+    // State inspection methods for testing
+    uint32_t getIoctlCount() const { return _ioctlCount; }
+    uint8_t getQueuedMessageCount() const { return _msgCount; }
+    bool isOpen() const { return _fd >= 0; }
+
+private:
+    const char* _devicePath;
+    int _fd;
+    bool _ownsFd;
+    IoctlFunction _ioctl;
+    uint32_t _ioctlCount;
+
+    // Pending combined transfer
+    struct i2c_msg _msgs[IS31FL373X_LINUX_I2C_MAX_MSGS];
+    uint8_t _msgCount;
+    uint8_t _queue[IS31FL373X_LINUX_I2C_QUEUE_BYTES];
+    size_t _queueUsed;
+    uint8_t _batchDepth;
+    bool _batchOk;
+
+    bool flush();
+    bool transfer(struct i2c_msg* msgs, uint32_t count);
+};
+
+#endif // __linux__
+#endif // IS31FL373X_LINUXI2C_H
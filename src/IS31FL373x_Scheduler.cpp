@@ -0,0 +1,80 @@
+#include "IS31FL373x_Scheduler.h"
+
+IS31FL373x_FrameScheduler::IS31FL373x_FrameScheduler(IS31FL373x_Canvas* canvas, uint16_t fps)
+    : _canvas(canvas), _period(1000000UL / (fps ? fps : 30)), _deadline(0), _frame(0) {
+    resetStats();
+}
+
+void IS31FL373x_FrameScheduler::setTargetFps(uint16_t fps) {
+    if (fps == 0) return;
+    setFramePeriod(1000000UL / fps);
+}
+
+void IS31FL373x_FrameScheduler::setFramePeriod(uint32_t periodMicros) {
+    if (periodMicros == 0) return;
+    _period = periodMicros;
+}
+
+void IS31FL373x_FrameScheduler::start() {
+    _deadline = static_cast<uint32_t>(micros());
+    _frame = 0;
+    resetStats();
+}
+
+bool IS31FL373x_FrameScheduler::frameDue() {
+    // Signed difference keeps the comparison valid across micros() wraparound
+    int32_t lateness = static_cast<int32_t>(static_cast<uint32_t>(micros()) - _deadline);
+    if (lateness < 0) return false;
+    // Deadlines that passed entirely are dropped, so the caller draws the current frame
+    uint32_t missed = static_cast<uint32_t>(lateness) / _period;
+    _deadline += missed * _period;
+    _frame += missed;
+    _dropped += missed;
+    return true;
+}
+
+uint32_t IS31FL373x_FrameScheduler::getMicrosUntilDue() const {
+    int32_t remaining = static_cast<int32_t>(_deadline - static_cast<uint32_t>(micros()));
+    return (remaining > 0) ? static_cast<uint32_t>(remaining) : 0;
+}
+
+bool IS31FL373x_FrameScheduler::show() {
+    if (!frameDue()) return false;
+    uint32_t begin = static_cast<uint32_t>(micros());
+    uint32_t lateness = begin - _deadline;
+
+    if (_canvas != nullptr) _canvas->show();
+    uint32_t end = static_cast<uint32_t>(micros());
+    uint32_t flush = end - begin;
+
+    _shown++;
+    _totalFlush += flush;
+    if (flush > _maxFlush) _maxFlush = flush;
+    _totalLateness += lateness;
+    if (lateness > _maxLateness) _maxLateness = lateness;
+    if (_shown == 1) _windowStart = end;  // Rate is measured between flushes
+    _lastShow = end;
+
+    // Stay on the original grid; an overrun is dropped by the next frameDue()
+    _deadline += _period;
+    _frame++;
+    return true;
+}
+
+float IS31FL373x_FrameScheduler::getAchievedFps() const {
+    uint32_t elapsed = _lastShow - _windowStart;
+    if (_shown < 2 || elapsed == 0) return 0.0f;
+    // Intervals between the first and last flush in the window
+    return static_cast<float>(_shown - 1) * 1000000.0f / static_cast<float>(elapsed);
+}
+
+void IS31FL373x_FrameScheduler::resetStats() {
+    _shown = 0;
+    _dropped = 0;
+    _totalFlush = 0;
+    _maxFlush = 0;
+    _totalLateness = 0;
+    _maxLateness = 0;
+    _windowStart = static_cast<uint32_t>(micros());
+    _lastShow = _windowStart;
+}
@@ -0,0 +1,58 @@
+#ifndef IS31FL373X_SCHEDULER_H
+#define IS31FL373X_SCHEDULER_H
+
+#include "IS31FL373x.h"
+
+/**
+ * Frame pacing for a canvas
+ * Frames are due on a fixed grid of period-spaced deadlines measured with
+ * micros(), so late frames do not push later ones back (no drift). When a flush
+ * overruns by a whole period or more, the missed deadlines are dropped and the
+ * frame number jumps ahead so animations keep real-time speed.
+ *
+ *   if (pacer.frameDue()) {
+ *       drawFrame(pacer.getFrameNumber());
+ *       pacer.show();
+ *   }
+ */
+class IS31FL373x_FrameScheduler {
+public:
+    IS31FL373x_FrameScheduler(IS31FL373x_Canvas* canvas, uint16_t fps = 30);
+
+    void setTargetFps(uint16_t fps);               // 0 is ignored
+    void setFramePeriod(uint32_t periodMicros);
+    uint32_t getFramePeriod() const { return _period; }
+
+    void start();            // First frame due now; also restarts the statistics window
+    bool frameDue();         // Deadline reached; drops deadlines already missed (poll from loop())
+    bool show();             // Flush if due and advance the schedule; false when not due yet
+
+    uint32_t getFrameNumber() const { return _frame; }  // Frame to draw, counting dropped ones
+    uint32_t getMicrosUntilDue() const;                 // 0 when due
+
+    // Statistics since start()/resetStats()
+    uint32_t getFramesShown() const { return _shown; }
+    uint32_t getFramesDropped() const { return _dropped; }
+    float getAchievedFps() const;
+    uint32_t getAverageFlushMicros() const { return _shown ? _totalFlush / _shown : 0; }
+    uint32_t getMaxFlushMicros() const { return _maxFlush; }
+    uint32_t getJitterMicros() const { return _shown ? _totalLateness / _shown : 0; }  // Mean start lateness
+    uint32_t getMaxLatenessMicros() const { return _maxLateness; }
+    void resetStats();
+
+private:
+    IS31FL373x_Canvas* _canvas;
+    uint32_t _period;
+    uint32_t _deadline;      // micros() value the current frame is due at
+    uint32_t _frame;
+    uint32_t _windowStart;
+    uint32_t _lastShow;      // End of the last flush, for the fps window
+    uint32_t _shown;
+    uint32_t _dropped;
+    uint32_t _totalFlush;
+    uint32_t _maxFlush;
+    uint32_t _totalLateness;
+    uint32_t _maxLateness;
+};
+
+#endif // IS31FL373X_SCHEDULER_H
@@ -0,0 +1,40 @@
+/**
+ * @file capture_analyze.cpp
+ * @brief Command-line report for IS31FL373x binary I2C captures
+ *
+ * Build (any host with a C++11 compiler, no Arduino needed):
+ *   g++ -std=c++11 -O2 -Isrc tools/capture_analyze.cpp src/IS31FL373x_CaptureAnalyzer.cpp -o capture_analyze
+ *
+ * Usage:
+ *   ./capture_analyze capture.bin
+ */
+
+#include "IS31FL373x_CaptureAnalyzer.h"
+#include <stdio.h>
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <capture.bin>\n", argv[0]);
+        return 2;
+    }
+    FILE* in = fopen(argv[1], "rb");
+    if (in == nullptr) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    IS31FL373x_CaptureAnalyzer analyzer;
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        if (!analyzer.feed(buffer, count)) break;
+    }
+    fclose(in);
+
+    if (!analyzer.isValid()) {
+        fprintf(stderr, "%s: not an IS31FL373x capture (or corrupt)\n", argv[1]);
+        return 1;
+    }
+    analyzer.printReport(stdout);
+    return 0;
+}